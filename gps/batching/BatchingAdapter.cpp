@@ -39,7 +39,8 @@ using namespace loc_core;
 BatchingAdapter::BatchingAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   false, nullptr, true),
+                   false, nullptr, true,
+                   LocContext::getAdapterMsgTask("Loc_batching")),
     mOngoingTripDistance(0),
     mOngoingTripTBFInterval(0),
     mTripWithOngoingTBFDropped(false),
@@ -50,6 +51,8 @@ BatchingAdapter::BatchingAdapter() :
     mTripBatchSize(0)
 {
     LOC_LOGD("%s]: Constructor", __func__);
+    // has no use for the GnssDataNotification of position reports
+    setDataNotifyConsumer(false);
     readConfigCommand();
     setConfigCommand();
 
@@ -203,7 +206,7 @@ BatchingAdapter::restartSessions()
         if (it->second.batchingMode != BATCHING_MODE_TRIP) {
             mLocApi->startBatching(it->first.id, it->second,
                                     getBatchingAccuracy(), getBatchingTimeout(),
-                                    new LocApiResponse(*getContext(),
+                                    new LocApiTaskResponse(*getContext(), *getMsgTask(),
                                     [] (LocationError /*err*/) {}));
         }
     }
@@ -236,7 +239,8 @@ BatchingAdapter::restartSessions()
         }
 
         mLocApi->startOutdoorTripBatching(mOngoingTripDistance, mOngoingTripTBFInterval,
-                getBatchingTimeout(), new LocApiResponse(*getContext(), [this] (LocationError err) {
+                getBatchingTimeout(), new LocApiTaskResponse(*getContext(), *getMsgTask(),
+                [this] (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
                 mOngoingTripDistance = 0;
                 mOngoingTripTBFInterval = 0;
@@ -384,7 +388,7 @@ BatchingAdapter::startBatching(LocationAPI* client, uint32_t sessionId,
     // Assume start will be OK, remove session if not
     saveBatchingSession(client, sessionId, batchingOptions);
     mLocApi->startBatching(sessionId, batchingOptions, getBatchingAccuracy(), getBatchingTimeout(),
-            new LocApiResponse(*getContext(),
+            new LocApiTaskResponse(*getContext(), *getMsgTask(),
             [this, client, sessionId, batchingOptions] (LocationError err) {
         if (LOCATION_ERROR_SUCCESS != err) {
             eraseBatchingSession(client, sessionId);
@@ -506,7 +510,7 @@ BatchingAdapter::stopBatching(LocationAPI* client, uint32_t sessionId, bool rest
         // Assume stop will be OK, restore session if not
         eraseBatchingSession(client, sessionId);
         mLocApi->stopBatching(sessionId,
-                new LocApiResponse(*getContext(),
+                new LocApiTaskResponse(*getContext(), *getMsgTask(),
                 [this, client, sessionId, flpOptions, restartNeeded, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS != err) {
@@ -570,13 +574,14 @@ BatchingAdapter::getBatchedLocationsCommand(LocationAPI* client, uint32_t id, si
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (mAdapter.isTripSession(mSessionId)) {
                     mApi.getBatchedTripLocations(mCount, 0,
-                            new LocApiResponse(*mAdapter.getContext(),
+                            new LocApiTaskResponse(*mAdapter.getContext(), *mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
                         mAdapter.reportResponse(mClient, err, mSessionId);
                     }));
                 } else {
-                    mApi.getBatchedLocations(mCount, new LocApiResponse(*mAdapter.getContext(),
+                    mApi.getBatchedLocations(mCount, new LocApiTaskResponse(*mAdapter.getContext(),
+                                                                            *mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mSessionId = mSessionId,
                             mClient = mClient] (LocationError err) {
                         mAdapter.reportResponse(mClient, err, mSessionId);
@@ -764,7 +769,8 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
         mTripSessions[sessionId] = { 0, 0, 0, batchingOptions.minDistance,
                 batchingOptions.minInterval};
         mLocApi->startOutdoorTripBatching(batchingOptions.minDistance,
-                batchingOptions.minInterval, getBatchingTimeout(), new LocApiResponse(*getContext(),
+                batchingOptions.minInterval, getBatchingTimeout(),
+                new LocApiTaskResponse(*getContext(), *getMsgTask(),
                 [this, client, sessionId, batchingOptions] (LocationError err) {
             if (err == LOCATION_ERROR_SUCCESS) {
                 mOngoingTripDistance = batchingOptions.minDistance;
@@ -786,7 +792,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
     } else {
         // query accumulated distance
         mLocApi->queryAccumulatedTripDistance(
-                new LocApiResponseData<LocApiBatchData>(*getContext(),
+                new LocApiTaskResponseData<LocApiBatchData>(*getContext(), *getMsgTask(),
                 [this, batchingOptions, sessionId, client]
                 (LocationError err, LocApiBatchData data) {
             uint32_t accumulatedDistanceOngoingBatch = 0;
@@ -843,7 +849,7 @@ BatchingAdapter::startTripBatchingMultiplex(LocationAPI* client, uint32_t sessio
                             tripSessStatus.accumulatedDistanceThisTrip;
                 }
                 mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                        getBatchingTimeout(), new LocApiResponse(*getContext(),
+                        getBatchingTimeout(), new LocApiTaskResponse(*getContext(), *getMsgTask(),
                         [this, client, sessionId] (LocationError err) {
                     if (err != LOCATION_ERROR_SUCCESS) {
                         LOC_LOGE("%s] New Trip restart failed!", __func__);
@@ -864,7 +870,7 @@ BatchingAdapter::stopTripBatchingMultiplex(LocationAPI* client, uint32_t session
     LocationError err = LOCATION_ERROR_SUCCESS;
 
     if (mTripSessions.size() == 1) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiTaskResponse(*getContext(), *getMsgTask(),
                 [this, restartNeeded, client, sessionId, batchOptions]
                 (LocationError err) {
             if (LOCATION_ERROR_SUCCESS == err) {
@@ -931,7 +937,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
     // if no more trips left, stop the ongoing trip
     if (mTripSessions.size() == 0) {
-        mLocApi->stopOutdoorTripBatching(true, new LocApiResponse(*getContext(),
+        mLocApi->stopOutdoorTripBatching(true, new LocApiTaskResponse(*getContext(), *getMsgTask(),
                                                [] (LocationError /*err*/) {}));
         mOngoingTripDistance = 0;
         mOngoingTripTBFInterval = 0;
@@ -963,7 +969,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
     }
 
     mLocApi->queryAccumulatedTripDistance(
-            new LocApiResponseData<LocApiBatchData>(*getContext(),
+            new LocApiTaskResponseData<LocApiBatchData>(*getContext(), *getMsgTask(),
             [this, queryAccumulatedDistance, minRemainingDistance, minTBFInterval, accDist,
             numbatchedPos] (LocationError /*err*/, LocApiBatchData data) {
         bool needsRestart = false;
@@ -1003,7 +1009,7 @@ BatchingAdapter::restartTripBatching(bool queryAccumulatedDistance, uint32_t acc
 
         if (needsRestart) {
             mLocApi->reStartOutdoorTripBatching(ongoingTripDistance, ongoingTripInterval,
-                    getBatchingTimeout(), new LocApiResponse(*getContext(),
+                    getBatchingTimeout(), new LocApiTaskResponse(*getContext(), *getMsgTask(),
                     [this, accumulatedDistance, ongoingTripDistance, ongoingTripInterval]
                     (LocationError err) {
 
@@ -452,6 +452,44 @@ struct LocApiResponseData: LocMsg {
         }
 };
 
+// The LocApi, which may be prebuilt, returns every response to the context's
+// MsgTask. These ones, for an adapter with a MsgTask of its own, forward
+// procImpl from there to msgTask, so the adapter's state is still only ever
+// touched from its own thread.
+struct LocApiTaskResponse: LocApiResponse {
+    inline LocApiTaskResponse(ContextBase& context, const MsgTask& msgTask,
+                              std::function<void (LocationError err)> procImpl) :
+            LocApiResponse(context, forward(context, msgTask, procImpl)) {}
+private:
+    static inline std::function<void (LocationError err)> forward(
+            ContextBase& context, const MsgTask& msgTask,
+            std::function<void (LocationError err)> procImpl) {
+        if (context.getMsgTask() == &msgTask) {
+            return procImpl;
+        }
+        return [&msgTask, procImpl] (LocationError err) {
+            msgTask.sendMsg([procImpl, err] () { procImpl(err); });
+        };
+    }
+};
+
+template <typename DATA>
+struct LocApiTaskResponseData: LocApiResponseData<DATA> {
+    inline LocApiTaskResponseData(ContextBase& context, const MsgTask& msgTask,
+                              std::function<void (LocationError err, DATA data)> procImpl) :
+            LocApiResponseData<DATA>(context, forward(context, msgTask, procImpl)) {}
+private:
+    static inline std::function<void (LocationError err, DATA data)> forward(
+            ContextBase& context, const MsgTask& msgTask,
+            std::function<void (LocationError err, DATA data)> procImpl) {
+        if (context.getMsgTask() == &msgTask) {
+            return procImpl;
+        }
+        return [&msgTask, procImpl] (LocationError err, DATA data) {
+            msgTask.sendMsg([procImpl, err, data] () { procImpl(err, data); });
+        };
+    }
+};
 
 } // namespace loc_core
 
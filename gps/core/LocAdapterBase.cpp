@@ -71,9 +71,15 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <loc_target.h>
 #include <log_util.h>
 #include <LocAdapterProxyBase.h>
+#include <unordered_map>
 
 namespace loc_core {
 
+// The flags of the adapters that set any, by adapter. Kept out of
+// LocAdapterBase, whose layout prebuilt adapters were built with.
+static pthread_mutex_t sAdapterFlagsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::unordered_map<const LocAdapterBase*, uint32_t> sAdapterFlags;
+
 // This is the top level class, so the constructor will
 // always gets called. Here we prepare for the default.
 // But if getLocApi(targetEnumType target) is overriden,
@@ -82,9 +88,16 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
                                ContextBase* context, bool isMaster,
                                LocAdapterProxyBase *adapterProxyBase,
                                bool waitForDoneInit) :
+    LocAdapterBase(mask, context, isMaster, adapterProxyBase, waitForDoneInit, NULL) {}
+
+LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
+                               ContextBase* context, bool isMaster,
+                               LocAdapterProxyBase *adapterProxyBase,
+                               bool waitForDoneInit,
+                               const MsgTask* msgTask) :
     mIsMaster(isMaster), mEvtMask(mask), mContext(context),
     mLocApi(context->getLocApi()), mLocAdapterProxyBase(adapterProxyBase),
-    mMsgTask(context->getMsgTask()),
+    mMsgTask(NULL != msgTask ? msgTask : context->getMsgTask()),
     mIsEngineCapabilitiesKnown(ContextBase::sIsEngineCapabilitiesKnown)
 {
     LOC_LOGd("waitForDoneInit: %d", waitForDoneInit);
@@ -98,6 +111,30 @@ LocAdapterBase::LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
 
 uint32_t LocAdapterBase::mSessionIdCounter(1);
 
+void LocAdapterBase::setFlag(uint32_t flag, bool on)
+{
+    pthread_mutex_lock(&sAdapterFlagsMutex);
+    uint32_t& flags = sAdapterFlags[this];
+    flags = on ? (flags | flag) : (flags & ~flag);
+    pthread_mutex_unlock(&sAdapterFlagsMutex);
+}
+
+bool LocAdapterBase::getFlag(uint32_t flag) const
+{
+    pthread_mutex_lock(&sAdapterFlagsMutex);
+    auto it = sAdapterFlags.find(this);
+    bool on = (it != sAdapterFlags.end()) && (0 != (it->second & flag));
+    pthread_mutex_unlock(&sAdapterFlagsMutex);
+    return on;
+}
+
+void LocAdapterBase::clearFlags(const LocAdapterBase* adapter)
+{
+    pthread_mutex_lock(&sAdapterFlagsMutex);
+    sAdapterFlags.erase(adapter);
+    pthread_mutex_unlock(&sAdapterFlagsMutex);
+}
+
 uint32_t LocAdapterBase::generateSessionId()
 {
     if (++mSessionIdCounter == 0xFFFFFFFF)
@@ -120,6 +157,18 @@ void LocAdapterBase::handleEngineDownEvent()
     }
 }
 
+void LocAdapterBase::
+    reportPositionEvent(const LocFixPtr& fix)
+{
+    GnssDataNotification dataNotify = {};
+    if (nullptr != fix->mDataNotify) {
+        dataNotify = *fix->mDataNotify;
+    }
+    reportPositionEvent(fix->mLocation, fix->mLocationExtended, fix->mStatus,
+                        fix->mTechMask, (0 != dataNotify.size) ? &dataNotify : nullptr,
+                        fix->mMsInWeek);
+}
+
 void LocAdapterBase::
     reportPositionEvent(const UlpLocation& location,
                         const GpsLocationExtended& locationExtended,
@@ -31,6 +31,7 @@
 
 #include <gps_extended.h>
 #include <ContextBase.h>
+#include <LocFix.h>
 #include <LocationAPI.h>
 #include <map>
 
@@ -60,6 +61,8 @@ class LocAdapterProxyBase;
 
 class LocAdapterBase {
 private:
+    static const uint32_t FLAG_FIX_CONSUMER = (1 << 0);
+    static const uint32_t FLAG_NO_DATA_NOTIFY = (1 << 1);
     static uint32_t mSessionIdCounter;
     const bool mIsMaster;
     bool mIsEngineCapabilitiesKnown = false;
@@ -86,6 +89,15 @@ protected:
     LocationCallbacks getClientCallbacks(LocationAPI* client);
     LocationCapabilitiesMask getCapabilities();
     void broadcastCapabilities(LocationCapabilitiesMask mask);
+    // Only adapters built with reportPositionEvent(const LocFixPtr&) may
+    // call this, for LocApiBase to call that one instead of
+    // reportPositionEvent(const UlpLocation&, ...).
+    inline void setFixConsumer(bool fixConsumer) { setFlag(FLAG_FIX_CONSUMER, fixConsumer); }
+    inline void setDataNotifyConsumer(bool dataNotifyConsumer) {
+        setFlag(FLAG_NO_DATA_NOTIFY, !dataNotifyConsumer);
+    }
+    void setFlag(uint32_t flag, bool on);
+    bool getFlag(uint32_t flag) const;
     virtual void updateClientsEventMask();
     virtual void stopClientSessions(LocationAPI* client);
 
@@ -105,6 +117,14 @@ public:
                    ContextBase* context, bool isMaster = false,
                    LocAdapterProxyBase *adapterProxyBase = NULL,
                    bool waitForDoneInit = false);
+    // msgTask, if not NULL, is the MsgTask the adapter processes its msgs
+    // on instead of the context's one. Responses to its LocApi calls must
+    // then be LocApiTaskResponse's built with it.
+    LocAdapterBase(const LOC_API_ADAPTER_EVENT_MASK_T mask,
+                   ContextBase* context, bool isMaster,
+                   LocAdapterProxyBase *adapterProxyBase,
+                   bool waitForDoneInit,
+                   const MsgTask* msgTask);
 
     inline void doneInit() {
         if (!mAdapterAdded) {
@@ -130,6 +150,11 @@ public:
         mMsgTask->sendMsg(msg);
     }
 
+    template <typename T, typename... Args>
+    inline void emplaceMsg(Args&&... args) const {
+        mMsgTask->emplaceMsg<T>(std::forward<Args>(args)...);
+    }
+
     inline void updateEvtMask(LOC_API_ADAPTER_EVENT_MASK_T event,
                               loc_registration_mask_status status)
     {
@@ -199,6 +224,7 @@ public:
                                       const LocInEmergency emergencyState);
     inline virtual bool isInSession() { return false; }
     ContextBase* getContext() const { return mContext; }
+    const MsgTask* getMsgTask() const { return mMsgTask; }
     virtual void reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurements,
                                                 int msInWeek);
     virtual bool reportWwanZppFix(LocGpsLocation &zppLoc);
@@ -239,6 +265,23 @@ public:
     virtual void reportLatencyInfoEvent(const GnssLatencyInfo& gnssLatencyInfo);
     virtual bool reportQwesCapabilities(
             const std::unordered_map<LocationQwesFeatureType, bool> &featureMap);
+
+    /* What an adapter tells LocApiBase about itself. These are not virtual,
+       and their state is kept out of LocAdapterBase, so that LocApiBase may
+       call them on prebuilt adapters too, which only ever have the defaults. */
+    inline bool isFixConsumer() const { return getFlag(FLAG_FIX_CONSUMER); }
+    // Whether a GnssDataNotification that comes with a position report has
+    // any use here. If no adapter says so, LocApiBase leaves it out of the fix.
+    inline bool isDataNotifyConsumer() const { return !getFlag(FLAG_NO_DATA_NOTIFY); }
+    // called by LocApiBase once the adapter is removed
+    static void clearFlags(const LocAdapterBase* adapter);
+
+    /* new virtuals go last, to keep the vtable of prebuilt adapters valid */
+    // What LocApiBase::reportPosition delivers to the adapters that are
+    // isFixConsumer(). Adapters that keep the report past the call should
+    // override this one and hold on to fix; by default it is unpacked into
+    // reportPositionEvent(const UlpLocation&, ...).
+    virtual void reportPositionEvent(const LocFixPtr& fix);
 };
 
 } // namespace loc_core
@@ -241,6 +241,8 @@ void LocApiBase::addAdapter(LocAdapterBase* adapter)
 
 void LocApiBase::removeAdapter(LocAdapterBase* adapter)
 {
+    // an adapter built later at the same address starts over
+    LocAdapterBase::clearFlags(adapter);
     for (int i = 0;
          i < MAX_ADAPTERS && NULL != mLocAdapters[i];
          i++) {
@@ -343,12 +345,23 @@ void LocApiBase::reportPosition(UlpLocation& location,
              locationExtended.gnss_sv_used_ids.gal_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.qzss_sv_used_ids_mask,
              locationExtended.gnss_sv_used_ids.navic_sv_used_ids_mask);
+    // the data notification is only copied if some adapter has clients for it
+    bool dataNotifyWanted = false;
+    if (nullptr != pDataNotify) {
+        TO_1ST_HANDLING_LOCADAPTERS(
+                dataNotifyWanted = mLocAdapters[i]->isDataNotifyConsumer());
+    }
+    // the one copy of the report, shared by all adapters
+    LocFixPtr fix = LocFix::create(location, locationExtended, status, loc_technology_mask,
+                                   dataNotifyWanted ? pDataNotify : nullptr, msInWeek);
     // loop through adapters, and deliver to all adapters.
-    TO_ALL_LOCADAPTERS(
-        mLocAdapters[i]->reportPositionEvent(location, locationExtended,
-                                             status, loc_technology_mask,
-                                             pDataNotify, msInWeek)
-    );
+    // the msgs they post are handed to their MsgTasks in one go.
+    // Those not built with LocFix, which may be prebuilt, get it unpacked.
+    MsgTask::BatchScope batch;
+    TO_ALL_LOCADAPTERS(mLocAdapters[i]->isFixConsumer() ?
+            mLocAdapters[i]->reportPositionEvent(fix) :
+            mLocAdapters[i]->reportPositionEvent(location, locationExtended, status,
+                                                 loc_technology_mask, pDataNotify, msInWeek));
 }
 
 void LocApiBase::reportWwanZppFix(LocGpsLocation &zppLoc)
@@ -431,6 +444,7 @@ void LocApiBase::reportSv(GnssSvNotification& svNotify)
             svNotify.gnssSvs[i].gnssSignalTypeMask);
     }
     // loop through adapters, and deliver to all adapters.
+    MsgTask::BatchScope batch;
     TO_ALL_LOCADAPTERS(
         mLocAdapters[i]->reportSvEvent(svNotify)
         );
@@ -461,12 +475,14 @@ void LocApiBase::reportStatus(LocGpsStatusValue status)
 void LocApiBase::reportData(GnssDataNotification& dataNotify, int msInWeek)
 {
     // loop through adapters, and deliver to all adapters.
+    MsgTask::BatchScope batch;
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportDataEvent(dataNotify, msInWeek));
 }
 
 void LocApiBase::reportNmea(const char* nmea, int length)
 {
     // loop through adapters, and deliver to all adapters.
+    MsgTask::BatchScope batch;
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportNmeaEvent(nmea, length));
 }
 
@@ -545,6 +561,7 @@ LocApiProxyBase* LocApiBase :: getLocApiProxy()
 void LocApiBase::reportGnssMeasurements(GnssMeasurements& gnssMeasurements, int msInWeek)
 {
     // loop through adapters, and deliver to all adapters.
+    MsgTask::BatchScope batch;
     TO_ALL_LOCADAPTERS(mLocAdapters[i]->reportGnssMeasurementsEvent(gnssMeasurements, msInWeek));
 }
 
@@ -50,14 +50,51 @@ const char* LocContext::mLBSLibName = "liblbs_core.so.1";
 
 pthread_mutex_t LocContext::mGetLocContextMutex = PTHREAD_MUTEX_INITIALIZER;
 
+const MsgTask* LocContext::createMsgTask(const char* name)
+{
+    uint32_t msgQRingSize = 0;
+    uint32_t msgQDrainBatchSize = 1;
+    uint32_t msgTaskStats = 0;
+    loc_param_s_type msgQConfParamTable[] =
+    {
+        {"MSG_Q_RING_SIZE", &msgQRingSize, NULL, 'n'},
+        {"MSG_Q_DRAIN_BATCH_SIZE", &msgQDrainBatchSize, NULL, 'n'},
+        {"MSG_TASK_STATS", &msgTaskStats, NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, msgQConfParamTable);
+    LOC_LOGD("%s:%d]: %s MSG_Q_RING_SIZE %u MSG_Q_DRAIN_BATCH_SIZE %u MSG_TASK_STATS %u",
+             __func__, __LINE__, name, msgQRingSize, msgQDrainBatchSize, msgTaskStats);
+    const MsgTask* msgTask = new MsgTask(name, msgQRingSize, msgQDrainBatchSize);
+    msgTask->enableStats(0 != msgTaskStats);
+    return msgTask;
+}
+
 const MsgTask* LocContext::getMsgTask(const char* name)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(name);
+        mMsgTask = createMsgTask(name);
     }
     return mMsgTask;
 }
 
+const MsgTask* LocContext::getAdapterMsgTask(const char* name)
+{
+    uint32_t adapterMsgTasks = 0;
+    loc_param_s_type adapterConfParamTable[] =
+    {
+        {"ADAPTER_MSG_TASKS", &adapterMsgTasks, NULL, 'n'},
+    };
+    UTIL_READ_CONF(LOC_PATH_GPS_CONF, adapterConfParamTable);
+    LOC_LOGD("%s:%d]: %s ADAPTER_MSG_TASKS %u", __func__, __LINE__, name, adapterMsgTasks);
+
+    if (0 == adapterMsgTasks) {
+        // the context's MsgTask, which LocAdapterBase falls back to
+        return NULL;
+    }
+    // the adapters are singletons living as long as the process, so is this
+    return createMsgTask(name);
+}
+
 ContextBase* LocContext::getLocContext(const char* name)
 {
     pthread_mutex_lock(&LocContext::mGetLocContextMutex);
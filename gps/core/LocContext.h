@@ -39,6 +39,7 @@ namespace loc_core {
 class LocContext : public ContextBase {
     static const MsgTask* mMsgTask;
     static ContextBase* mContext;
+    static const MsgTask* createMsgTask(const char* name);
     static const MsgTask* getMsgTask(const char* name);
     static pthread_mutex_t mGetLocContextMutex;
 
@@ -52,6 +53,11 @@ public:
 
     static ContextBase* getLocContext(const char* name);
 
+    // MsgTask of its own for an adapter that does not share state with the
+    // others, if ADAPTER_MSG_TASKS is set in gps.conf; NULL to share the
+    // context's one. name must be shorter than 15 chars.
+    static const MsgTask* getAdapterMsgTask(const char* name);
+
     static void injectFeatureConfig(ContextBase *context);
 };
 
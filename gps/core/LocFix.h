@@ -0,0 +1,107 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef LOC_FIX_H
+#define LOC_FIX_H
+
+#include <memory>
+#include <mutex>
+#include <gps_extended.h>
+#include <LocationDataTypes.h>
+
+namespace loc_core {
+
+class LocFix;
+typedef std::shared_ptr<const LocFix> LocFixPtr;
+
+// A position report as the LocApi hands it over. It is created once and
+// then shared, read only, by every adapter and msg it goes through, instead
+// of each of them taking a copy. What the clients get, the
+// GnssLocationInfoNotification, is converted on first use and kept with it.
+class LocFix {
+public:
+    typedef void (*LocationInfoConverter)(GnssLocationInfoNotification& out,
+                                          const LocFix& fix);
+
+    const UlpLocation mLocation;
+    const GpsLocationExtended mLocationExtended;
+    const enum loc_sess_status mStatus;
+    const LocPosTechMask mTechMask;
+    // null if the report came without one, or no adapter consumes it
+    const std::unique_ptr<const GnssDataNotification> mDataNotify;
+    const int mMsInWeek;
+
+    inline static LocFixPtr create(const UlpLocation& location,
+                                   const GpsLocationExtended& locationExtended,
+                                   enum loc_sess_status status,
+                                   LocPosTechMask techMask,
+                                   const GnssDataNotification* pDataNotify = nullptr,
+                                   int msInWeek = -1) {
+        return std::make_shared<const LocFix>(location, locationExtended, status, techMask,
+                                              pDataNotify, msInWeek);
+    }
+
+    inline LocFix(const UlpLocation& location,
+                  const GpsLocationExtended& locationExtended,
+                  enum loc_sess_status status,
+                  LocPosTechMask techMask,
+                  const GnssDataNotification* pDataNotify,
+                  int msInWeek) :
+        mLocation(location), mLocationExtended(locationExtended),
+        mStatus(status), mTechMask(techMask),
+        mDataNotify(dataNotifyOf(pDataNotify)), mMsInWeek(msInWeek),
+        mLocationInfo() {}
+
+    // convert runs at most once per fix, whichever thread gets here first
+    inline const GnssLocationInfoNotification&
+            getLocationInfo(LocationInfoConverter convert) const {
+        std::call_once(mLocationInfoOnce, [this, convert] { convert(mLocationInfo, *this); });
+        return mLocationInfo;
+    }
+
+private:
+    mutable std::once_flag mLocationInfoOnce;
+    mutable GnssLocationInfoNotification mLocationInfo;
+
+    inline static const GnssDataNotification*
+            dataNotifyOf(const GnssDataNotification* pDataNotify) {
+        GnssDataNotification* dataNotify = nullptr;
+        if (nullptr != pDataNotify) {
+            dataNotify = new GnssDataNotification(*pDataNotify);
+            dataNotify->size = sizeof(*dataNotify);
+        }
+        return dataNotify;
+    }
+
+    LocFix(const LocFix&) = delete;
+    LocFix& operator=(const LocFix&) = delete;
+};
+
+} // namespace loc_core
+
+#endif // LOC_FIX_H
@@ -85,46 +85,139 @@ namespace loc_core
 /******************************************************************************
  SystemStatusNmeaBase - base class for all NMEA parsers
 ******************************************************************************/
+// the tag of a $PQW sentence, from the two characters following the talker
+#define NMEA_DEBUG_TAG(c4, c5) ((((uint32_t)(uint8_t)(c4)) << 8) | ((uint8_t)(c5)))
+
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // the longest sentence, $PQWP7, has talker, time and 3 fields per SV
+    static const uint32_t NMEA_MAXFIELDS = 2 + SV_ALL_NUM*3;
+
+private:
+    // a field is where it sits in the sentence, which stays the caller's
+    struct Field {
+        uint16_t offset;
+        uint16_t length;
+    };
+    const char* mSentence;
+    Field mField[NMEA_MAXFIELDS];
+
+    // copies a field out for the libc conversions, which need it terminated;
+    // returns false if it does not fit
+    inline bool copyField(uint32_t i, char* buf, size_t size) const {
+        if (mField[i].length >= size) {
+            return false;
+        }
+        memcpy(buf, mSentence + mField[i].offset, mField[i].length);
+        buf[mField[i].length] = '\0';
+        return true;
+    }
+
 protected:
-    std::vector<std::string> mField;
+    uint32_t mFieldCount;
 
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    SystemStatusNmeaBase(const char *str_in, uint32_t len_in) :
+        mSentence(str_in), mFieldCount(0)
     {
         // check size and talker
         if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
+        uint32_t length = strnlen(str_in, len_in);
         // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+        const char* star = (const char*)memchr(str_in, '*', length);
+        if (nullptr == star) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
+
+        // tokenize in one pass, the '*' ending the last field like a ','
+        // does; whatever follows the last delimiter is not a field
+        uint32_t begin = 0;
+        for (uint32_t i = 0; i < length && mFieldCount < NMEA_MAXFIELDS; i++) {
+            if (',' == str_in[i] || str_in + i == star) {
+                mField[mFieldCount].offset = begin;
+                mField[mFieldCount].length = i - begin;
+                mFieldCount++;
+                begin = i + 1;
             }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
         }
     }
 
     virtual ~SystemStatusNmeaBase() { }
 
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+    // field i as atoi() would read it
+    int getInt(uint32_t i) const {
+        const char* p = mSentence + mField[i].offset;
+        uint32_t length = mField[i].length;
+        bool negative = (length > 0 && '-' == *p);
+        if (negative) {
+            p++;
+            length--;
+        }
+        // plain digits short enough not to overflow are the usual case
+        if (length <= 9) {
+            int value = 0;
+            uint32_t j = 0;
+            for (; j < length && p[j] >= '0' && p[j] <= '9'; j++) {
+                value = value*10 + (p[j] - '0');
+            }
+            if (j == length) {
+                return negative ? -value : value;
+            }
+        }
+        char buf[64];
+        return copyField(i, buf, sizeof(buf)) ? atoi(buf) :
+                atoi(std::string(mSentence + mField[i].offset, mField[i].length).c_str());
+    }
+
+    // field i as strtol(, NULL, 16) would read it
+    long getHex(uint32_t i) const {
+        const char* p = mSentence + mField[i].offset;
+        uint32_t length = mField[i].length;
+        if (length <= 15) {
+            uint64_t value = 0;
+            uint32_t j = 0;
+            for (; j < length; j++) {
+                char c = p[j];
+                if (c >= '0' && c <= '9') {
+                    value = (value << 4) | (c - '0');
+                } else if (c >= 'a' && c <= 'f') {
+                    value = (value << 4) | (c - 'a' + 10);
+                } else if (c >= 'A' && c <= 'F') {
+                    value = (value << 4) | (c - 'A' + 10);
+                } else {
+                    break;
+                }
+            }
+            // a 32 bit long takes at most 7 digits without saturating
+            if (j == length && (sizeof(long) > 4 || length <= 7)) {
+                return (long)value;
+            }
+        }
+        char buf[64];
+        return copyField(i, buf, sizeof(buf)) ? strtol(buf, NULL, 16) :
+                strtol(std::string(mSentence + mField[i].offset, mField[i].length).c_str(),
+                       NULL, 16);
+    }
+
+    // field i as strtoull(, NULL, 10) would read it
+    unsigned long long getU64(uint32_t i) const {
+        char buf[64];
+        return copyField(i, buf, sizeof(buf)) ? strtoull(buf, NULL, 10) :
+                strtoull(std::string(mSentence + mField[i].offset, mField[i].length).c_str(),
+                         NULL, 10);
+    }
+
+    // field i as atof() would read it
+    double getDouble(uint32_t i) const {
+        char buf[64];
+        return copyField(i, buf, sizeof(buf)) ? atof(buf) :
+                atof(std::string(mSentence + mField[i].offset, mField[i].length).c_str());
+    }
 };
 
 /******************************************************************************
@@ -246,47 +339,47 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         memset(&mM1, 0, sizeof(mM1));
-        if (mField.size() <= eMax0) {
-            LOC_LOGE("PQWM1parser - invalid size=%zu", mField.size());
+        if (mFieldCount <= eMax0) {
+            LOC_LOGE("PQWM1parser - invalid size=%u", mFieldCount);
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
-        if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+        mM1.mGpsWeek = getInt(eGpsWeek);
+        mM1.mGpsTowMs = getInt(eGpsTowMs);
+        mM1.mTimeValid = getInt(eTimeValid);
+        mM1.mTimeSource = getInt(eTimeSource);
+        mM1.mTimeUnc = getInt(eTimeUnc);
+        mM1.mClockFreqBias = getInt(eClockFreqBias);
+        mM1.mClockFreqBiasUnc = getInt(eClockFreqBiasUnc);
+        mM1.mXoState = getInt(eXoState);
+        mM1.mPgaGain = getInt(ePgaGain);
+        mM1.mGpsBpAmpI = getInt(eGpsBpAmpI);
+        mM1.mGpsBpAmpQ = getInt(eGpsBpAmpQ);
+        mM1.mAdcI = getInt(eAdcI);
+        mM1.mAdcQ = getInt(eAdcQ);
+        mM1.mJammerGps = getInt(eJammerGps);
+        mM1.mJammerGlo = getInt(eJammerGlo);
+        mM1.mJammerBds = getInt(eJammerBds);
+        mM1.mJammerGal = getInt(eJammerGal);
+        mM1.mRecErrorRecovery = getInt(eRecErrorRecovery);
+        mM1.mAgcGps = getDouble(eAgcGps);
+        mM1.mAgcGlo = getDouble(eAgcGlo);
+        mM1.mAgcBds = getDouble(eAgcBds);
+        mM1.mAgcGal = getDouble(eAgcGal);
+        if (mFieldCount > eLeapSecUnc) {
+            mM1.mLeapSeconds = getInt(eLeapSeconds);
+            mM1.mLeapSecUnc = getInt(eLeapSecUnc);
         }
-        if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+        if (mFieldCount > eGalBpAmpQ) {
+            mM1.mGloBpAmpI = getInt(eGloBpAmpI);
+            mM1.mGloBpAmpQ = getInt(eGloBpAmpQ);
+            mM1.mBdsBpAmpI = getInt(eBdsBpAmpI);
+            mM1.mBdsBpAmpQ = getInt(eBdsBpAmpQ);
+            mM1.mGalBpAmpI = getInt(eGalBpAmpI);
+            mM1.mGalBpAmpQ = getInt(eGalBpAmpQ);
         }
-        if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+        if (mFieldCount > eTimeUncNs) {
+            mM1.mTimeUncNs = getU64(eTimeUncNs);
         }
     }
 
@@ -338,17 +431,17 @@ public:
     SystemStatusPQWP1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = getHex(eEpiValidity);
+        mP1.mEpiLat = getDouble(eEpiLat);
+        mP1.mEpiLon = getDouble(eEpiLon);
+        mP1.mEpiAlt = getDouble(eEpiAlt);
+        mP1.mEpiHepe = getInt(eEpiHepe);
+        mP1.mEpiAltUnc = getDouble(eEpiAltUnc);
+        mP1.mEpiSrc = getInt(eEpiSrc);
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -393,15 +486,15 @@ public:
     SystemStatusPQWP2parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = getDouble(eBestLat);
+        mP2.mBestLon = getDouble(eBestLon);
+        mP2.mBestAlt = getDouble(eBestAlt);
+        mP2.mBestHepe = getDouble(eBestHepe);
+        mP2.mBestAltUnc = getDouble(eBestAltUnc);
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -469,22 +562,22 @@ public:
     SystemStatusPQWP3parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = getHex(eXtraValidMask);
+        mP3.mGpsXtraAge = getInt(eGpsXtraAge);
+        mP3.mGloXtraAge = getInt(eGloXtraAge);
+        mP3.mBdsXtraAge = getInt(eBdsXtraAge);
+        mP3.mGalXtraAge = getInt(eGalXtraAge);
+        mP3.mQzssXtraAge = getInt(eQzssXtraAge);
+        mP3.mGpsXtraValid = getHex(eGpsXtraValid);
+        mP3.mGloXtraValid = getHex(eGloXtraValid);
+        mP3.mBdsXtraValid = getHex(eBdsXtraValid);
+        mP3.mGalXtraValid = getHex(eGalXtraValid);
+        mP3.mQzssXtraValid = getHex(eQzssXtraValid);
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -529,15 +622,15 @@ public:
     SystemStatusPQWP4parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = getHex(eGpsEpheValid);
+        mP4.mGloEpheValid = getHex(eGloEpheValid);
+        mP4.mBdsEpheValid = getHex(eBdsEpheValid);
+        mP4.mGalEpheValid = getHex(eGalEpheValid);
+        mP4.mQzssEpheValid = getHex(eQzssEpheValid);
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -619,26 +712,26 @@ public:
     SystemStatusPQWP5parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = getHex(eGpsUnknownMask);
+        mP5.mGloUnknownMask = getHex(eGloUnknownMask);
+        mP5.mBdsUnknownMask = getHex(eBdsUnknownMask);
+        mP5.mGalUnknownMask = getHex(eGalUnknownMask);
+        mP5.mQzssUnknownMask = getHex(eQzssUnknownMask);
+        mP5.mGpsGoodMask = getHex(eGpsGoodMask);
+        mP5.mGloGoodMask = getHex(eGloGoodMask);
+        mP5.mBdsGoodMask = getHex(eBdsGoodMask);
+        mP5.mGalGoodMask = getHex(eGalGoodMask);
+        mP5.mQzssGoodMask = getHex(eQzssGoodMask);
+        mP5.mGpsBadMask = getHex(eGpsBadMask);
+        mP5.mGloBadMask = getHex(eGloBadMask);
+        mP5.mBdsBadMask = getHex(eBdsBadMask);
+        mP5.mGalBadMask = getHex(eGalBadMask);
+        mP5.mQzssBadMask = getHex(eQzssBadMask);
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -671,11 +764,11 @@ public:
     SystemStatusPQWP6parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = getHex(eFixInfoMask);
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -707,20 +800,20 @@ public:
         : SystemStatusNmeaBase(str_in, len_in)
     {
         uint32_t svLimit = SV_ALL_NUM;
-        if (mField.size() < eMin) {
-            LOC_LOGE("PQWP7parser - invalid size=%zu", mField.size());
+        if (mFieldCount < eMin) {
+            LOC_LOGE("PQWP7parser - invalid size=%u", mFieldCount);
             return;
         }
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             // Try reducing limit, accounting for possibly missing NAVIC support
             svLimit = SV_ALL_NUM_MIN;
         }
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(getInt(i*3+2));
+            mP7.mNav[i].mSource = GnssEphemerisSource(getInt(i*3+3));
+            mP7.mNav[i].mAgeSec = getInt(i*3+4);
         }
     }
 
@@ -757,12 +850,12 @@ public:
     SystemStatusPQWS1parser(const char *str_in, uint32_t len_in)
         : SystemStatusNmeaBase(str_in, len_in)
     {
-        if (mField.size() < eMax) {
+        if (mFieldCount < eMax) {
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = getInt(eFixInfoMask);
+        mS1.mHepeLimit = getInt(eHepeLimit);
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1315,12 +1408,16 @@ void SystemStatus::destroyInstance()
 }
 
 void SystemStatus::resetNetworkInfo() {
-    for (int i=0; i<mCache.mNetworkInfo.size(); ++i) {
+    // taken under the lock and never changed, while the notifications below
+    // update the cache itself
+    SystemStatusSnapshot snapshot = getSnapshot();
+    const SystemStatusHistory<SystemStatusNetworkInfo>& networkInfo = snapshot->mNetworkInfo;
+    for (size_t i = 0; i < networkInfo.size(); ++i) {
         // Reset all the cached NetworkInfo Items as disconnected
-        eventConnectionStatus(false, mCache.mNetworkInfo[i].mDataItem.mType,
-                mCache.mNetworkInfo[i].mDataItem.mRoaming,
-                mCache.mNetworkInfo[i].mDataItem.mNetworkHandle,
-                mCache.mNetworkInfo[i].mDataItem.mApn);
+        const NetworkInfoDataItem& dataItem = networkInfo.at(i).mDataItem;
+        string apn(dataItem.mApn);
+        eventConnectionStatus(false, dataItem.mType, dataItem.mRoaming,
+                dataItem.mNetworkHandle, apn);
     }
 }
 
@@ -1330,7 +1427,9 @@ IOsObserver* SystemStatus::getOsObserver()
 }
 
 SystemStatus::SystemStatus(const MsgTask* msgTask) :
-    mSysStatusObsvr(this, msgTask)
+    mSysStatusObsvr(this, msgTask),
+    mCacheVersion(0),
+    mSnapshotVersion(0)
 {
     int result = 0;
     ENTRY_LOG ();
@@ -1386,27 +1485,32 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
     if (s.ignore()) {
         return false;
     }
-    if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
-        // there is no change - just update reported timestamp
-        report.back().mUtcReported = s.mUtcReported;
-        return false;
+    if (!report.empty()) {
+        // read without copying a ring a snapshot shares; collate() and
+        // equals() only read their peer, but are not const
+        TYPE_ITEM& last = const_cast<TYPE_ITEM&>(report.last());
+        if (last.equals(static_cast<TYPE_ITEM&>(s.collate(last)))) {
+            // there is no change - just update reported timestamp, unless a
+            // snapshot shares the item; the snapshots keep the one they had
+            TYPE_ITEM* unshared = report.lastUnshared();
+            if (nullptr != unshared) {
+                unshared->mUtcReported = s.mUtcReported;
+            }
+            return false;
+        }
     }
 
-    // first event or updated
+    // first event or updated, replacing the oldest one once full
+    mCacheVersion++;
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
+    mCacheVersion++;
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
@@ -1433,53 +1537,54 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
     pthread_mutex_lock(&mMutexSystemStatus);
 
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
+    // parse the received nmea strings here, in place; the talker is "$PQW"
+    // already, so the two characters after it tell the sentences apart
+    switch (NMEA_DEBUG_TAG(data[4], data[5])) {
+    case NMEA_DEBUG_TAG('M', '1'): {
+        SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
         setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
         setIteminReport(mCache.mXoState, SystemStatusXoState(s));
         setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
         setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
+        break;
     }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+    case NMEA_DEBUG_TAG('P', '1'):
         setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusInjectedPosition(SystemStatusPQWP1parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '2'):
         setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusBestPosition(SystemStatusPQWP2parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '3'):
         setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusXtra(SystemStatusPQWP3parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '4'):
         setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusEphemeris(SystemStatusPQWP4parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '5'):
         setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusSvHealth(SystemStatusPQWP5parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '6'):
         setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusPdr(SystemStatusPQWP6parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('P', '7'):
         setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
+                SystemStatusNavData(SystemStatusPQWP7parser(data, len).get()));
+        break;
+    case NMEA_DEBUG_TAG('S', '1'):
         setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
-    }
-    else {
+                SystemStatusPositionFailure(SystemStatusPQWS1parser(data, len).get()));
+        break;
+    default:
         // do nothing
+        break;
     }
 
     pthread_mutex_unlock(&mMutexSystemStatus);
@@ -1549,9 +1654,9 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
             // Update latest mAllTypes/mAllNetworkHandles of original obj to notify clients
             if (ret) {
                 (static_cast<NetworkInfoDataItem*>(dataitem))->mAllTypes =
-                        mCache.mNetworkInfo.back().mDataItem.mAllTypes;
+                        mCache.mNetworkInfo.last().mDataItem.mAllTypes;
                 memcpy((static_cast<NetworkInfoDataItem*>(dataitem))->mAllNetworkHandles,
-                        mCache.mNetworkInfo.back().mDataItem.mAllNetworkHandles, sizeof((
+                        mCache.mNetworkInfo.last().mDataItem.mAllNetworkHandles, sizeof((
                         static_cast<NetworkInfoDataItem*>(dataitem))->mAllNetworkHandles));
             }
             break;
@@ -1692,47 +1797,8 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
         getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
     }
     else {
-        // copy entire reports and return them
-        report.mLocation.clear();
-
-        report.mTimeAndClock.clear();
-        report.mXoState.clear();
-        report.mRfAndParams.clear();
-        report.mErrRecovery.clear();
-
-        report.mInjectedPosition.clear();
-        report.mBestPosition.clear();
-        report.mXtra.clear();
-        report.mEphemeris.clear();
-        report.mSvHealth.clear();
-        report.mPdr.clear();
-        report.mNavData.clear();
-
-        report.mPositionFailure.clear();
-
-        report.mAirplaneMode.clear();
-        report.mENH.clear();
-        report.mGPSState.clear();
-        report.mNLPStatus.clear();
-        report.mWifiHardwareState.clear();
-        report.mNetworkInfo.clear();
-        report.mRilServiceInfo.clear();
-        report.mRilCellInfo.clear();
-        report.mServiceStatus.clear();
-        report.mModel.clear();
-        report.mManufacturer.clear();
-        report.mAssistedGps.clear();
-        report.mScreenState.clear();
-        report.mPowerConnectState.clear();
-        report.mTimeZoneChange.clear();
-        report.mTimeChange.clear();
-        report.mWifiSupplicantStatus.clear();
-        report.mShutdownState.clear();
-        report.mTac.clear();
-        report.mMccMnc.clear();
-        report.mBtDeviceScanDetail.clear();
-        report.mBtLeDeviceScanDetail.clear();
-
+        // copy entire reports and return them; they share the items with
+        // the cache until either side updates them
         report = mCache;
     }
 
@@ -1740,6 +1806,30 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
     return true;
 }
 
+/******************************************************************************
+@brief      API to get a snapshot of the report data
+
+@param[In]  none
+
+@return     the reports as they are now, unaffected by later updates
+******************************************************************************/
+SystemStatusSnapshot SystemStatus::getSnapshot() const
+{
+    pthread_mutex_lock(&mMutexSystemStatus);
+
+    // nothing changed since the last snapshot still held: hand it out again;
+    // otherwise the new one only shares the cache's items, copying none
+    SystemStatusSnapshot snapshot = mSnapshot.lock();
+    if (nullptr == snapshot || mSnapshotVersion != mCacheVersion) {
+        snapshot = std::make_shared<const SystemStatusReports>(mCache);
+        mSnapshot = snapshot;
+        mSnapshotVersion = mCacheVersion;
+    }
+
+    pthread_mutex_unlock(&mMutexSystemStatus);
+    return snapshot;
+}
+
 /******************************************************************************
 @brief      API to set default report data
 
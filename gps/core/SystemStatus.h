@@ -70,7 +70,11 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sys/time.h>
 #include <vector>
 #include <algorithm>
+#include <atomic>
 #include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <MsgTask.h>
@@ -856,6 +860,110 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory - the last maxItem items of one kind, oldest first
+******************************************************************************/
+// Items live in place in a ring: once it is full, a new item is assigned
+// over the oldest one, so an update never moves or reallocates the others.
+// Copies of a history share the ring until one of them changes it, which
+// is what makes SystemStatus snapshots cheap.
+template <typename TYPE_ITEM>
+class SystemStatusHistory
+{
+private:
+    static const uint32_t CAPACITY = TYPE_ITEM::maxItem;
+
+    struct Ring {
+        typename std::aligned_storage<sizeof(TYPE_ITEM), alignof(TYPE_ITEM)>::type
+                mSlot[CAPACITY];
+        uint32_t mFirst;
+        uint32_t mSize;
+
+        inline Ring() : mFirst(0), mSize(0) {}
+        inline Ring(const Ring& other) : mFirst(0), mSize(0) {
+            for (; mSize < other.mSize; mSize++) {
+                new (&at(mSize)) TYPE_ITEM(other.at(mSize));
+            }
+        }
+        inline ~Ring() { clear(); }
+        Ring& operator=(const Ring&) = delete;
+
+        inline TYPE_ITEM& at(uint32_t i) {
+            return *reinterpret_cast<TYPE_ITEM*>(&mSlot[(mFirst + i) % CAPACITY]);
+        }
+        inline const TYPE_ITEM& at(uint32_t i) const {
+            return *reinterpret_cast<const TYPE_ITEM*>(&mSlot[(mFirst + i) % CAPACITY]);
+        }
+
+        // drops the oldest item when full
+        void push_back(const TYPE_ITEM& item) {
+            if (mSize < CAPACITY) {
+                new (&at(mSize)) TYPE_ITEM(item);
+                mSize++;
+            } else {
+                at(0) = item;
+                mFirst = (mFirst + 1) % CAPACITY;
+            }
+        }
+
+        void clear() {
+            for (uint32_t i = 0; i < mSize; i++) {
+                at(i).~TYPE_ITEM();
+            }
+            mFirst = 0;
+            mSize = 0;
+        }
+    };
+    std::shared_ptr<Ring> mRing;
+
+    // the ring to change, copied first if another history still shares it
+    inline Ring& own() {
+        if (nullptr == mRing) {
+            mRing = std::make_shared<Ring>();
+        } else if (1 != mRing.use_count()) {
+            mRing = std::make_shared<Ring>(*mRing);
+        } else {
+            // pairs with the release of the last other holder, whose reads of
+            // the ring must be done before it is written here
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *mRing;
+    }
+
+public:
+    inline bool empty() const { return nullptr == mRing || 0 == mRing->mSize; }
+    inline size_t size() const { return (nullptr == mRing) ? 0 : mRing->mSize; }
+    inline TYPE_ITEM& operator[](size_t i) { return own().at(i); }
+    inline const TYPE_ITEM& operator[](size_t i) const { return mRing->at(i); }
+    inline TYPE_ITEM& front() { return own().at(0); }
+    inline const TYPE_ITEM& front() const { return mRing->at(0); }
+    inline TYPE_ITEM& back() { Ring& ring = own(); return ring.at(ring.mSize - 1); }
+    inline const TYPE_ITEM& back() const { return mRing->at(mRing->mSize - 1); }
+    // reads that never copy the ring, also on a history that is not const
+    inline const TYPE_ITEM& at(size_t i) const { return mRing->at(i); }
+    inline const TYPE_ITEM& last() const { return mRing->at(mRing->mSize - 1); }
+    // the last item, to change in place, or nullptr while another history
+    // still shares the ring, which would have to be copied first
+    inline TYPE_ITEM* lastUnshared() {
+        if (nullptr == mRing || 0 == mRing->mSize || 1 != mRing.use_count()) {
+            return nullptr;
+        }
+        return &own().at(mRing->mSize - 1);
+    }
+
+    // drops the oldest item when full
+    inline void push_back(const TYPE_ITEM& item) { own().push_back(item); }
+
+    inline void clear() {
+        if (nullptr != mRing && 1 == mRing.use_count()) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            mRing->clear();
+        } else {
+            mRing.reset();
+        }
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
@@ -863,53 +971,56 @@ class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusHistory<SystemStatusLocation>         mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusHistory<SystemStatusTimeAndClock>     mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>          mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>      mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>      mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusHistory<SystemStatusInjectedPosition> mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>     mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>             mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>        mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>         mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>              mPdr;
+    SystemStatusHistory<SystemStatusNavData>          mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusHistory<SystemStatusPositionFailure>  mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusInEmergencyCall>  mInEmergencyCall;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
-    std::vector<SystemStatusLocFeatureStatus>  mLocFeatureStatus;
+    SystemStatusHistory<SystemStatusAirplaneMode>     mAirplaneMode;
+    SystemStatusHistory<SystemStatusENH>              mENH;
+    SystemStatusHistory<SystemStatusGpsState>         mGPSState;
+    SystemStatusHistory<SystemStatusNLPStatus>        mNLPStatus;
+    SystemStatusHistory<SystemStatusWifiHardwareState> mWifiHardwareState;
+    SystemStatusHistory<SystemStatusNetworkInfo>      mNetworkInfo;
+    SystemStatusHistory<SystemStatusServiceInfo>      mRilServiceInfo;
+    SystemStatusHistory<SystemStatusRilCellInfo>      mRilCellInfo;
+    SystemStatusHistory<SystemStatusServiceStatus>    mServiceStatus;
+    SystemStatusHistory<SystemStatusModel>            mModel;
+    SystemStatusHistory<SystemStatusManufacturer>     mManufacturer;
+    SystemStatusHistory<SystemStatusInEmergencyCall>  mInEmergencyCall;
+    SystemStatusHistory<SystemStatusAssistedGps>      mAssistedGps;
+    SystemStatusHistory<SystemStatusScreenState>      mScreenState;
+    SystemStatusHistory<SystemStatusPowerConnectState> mPowerConnectState;
+    SystemStatusHistory<SystemStatusTimeZoneChange>   mTimeZoneChange;
+    SystemStatusHistory<SystemStatusTimeChange>       mTimeChange;
+    SystemStatusHistory<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    SystemStatusHistory<SystemStatusShutdownState>    mShutdownState;
+    SystemStatusHistory<SystemStatusTac>              mTac;
+    SystemStatusHistory<SystemStatusMccMnc>           mMccMnc;
+    SystemStatusHistory<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    SystemStatusHistory<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    SystemStatusHistory<SystemStatusLocFeatureStatus> mLocFeatureStatus;
 };
 
+// the reports as they were when it was taken, never changed afterwards
+typedef std::shared_ptr<const SystemStatusReports> SystemStatusSnapshot;
+
 /******************************************************************************
  SystemStatus
 ******************************************************************************/
@@ -926,6 +1037,11 @@ private:
     // Data members
     static pthread_mutex_t                    mMutexSystemStatus;
     SystemStatusReports mCache;
+    // bumped on every change to mCache, so that readers at the same version
+    // share one snapshot for as long as any of them holds it
+    uint64_t mCacheVersion;
+    mutable uint64_t mSnapshotVersion;
+    mutable std::weak_ptr<const SystemStatusReports> mSnapshot;
 
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     bool setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s);
@@ -948,6 +1064,7 @@ public:
     bool eventDataItemNotify(IDataItemCore* dataitem);
     bool setNmeaString(const char *data, uint32_t len);
     bool getReport(SystemStatusReports& reports, bool isLatestonly = false) const;
+    SystemStatusSnapshot getSnapshot() const;
     bool setDefaultGnssEngineStates(void);
     bool eventConnectionStatus(bool connected, int8_t type,
                                bool roaming, NetworkHandle networkHandle, string& apn);
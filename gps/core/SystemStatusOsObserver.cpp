@@ -47,13 +47,12 @@ COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
 
 SystemStatusOsObserver::~SystemStatusOsObserver() {
     // Destroy cache
-    for (auto each : mDataItemCache) {
-        if (nullptr != each.second) {
-            delete each.second;
+    for (auto& each : mDataItemCache) {
+        if (nullptr != each) {
+            delete each;
+            each = nullptr;
         }
     }
-
-    mDataItemCache.clear();
 }
 
 void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscriptionObj)
@@ -69,7 +68,7 @@ void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscript
 
             if (!mContext.mSSObserver->mDataItemToClients.empty()) {
                 list<DataItemId> dis(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                        containerTransfer<DataItemIdSet, list<DataItemId>>(
                                 mContext.mSSObserver->mDataItemToClients.getKeys()));
                 mContext.mSubscriptionObj->subscribe(dis, mContext.mSSObserver);
                 mContext.mSubscriptionObj->requestData(dis, mContext.mSSObserver);
@@ -95,12 +94,12 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         inline HandleSubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)),
+                mDataItemSet(containerTransfer<list<DataItemId>, DataItemIdSet>(l)),
                 diItemlist(l),
                 mToRequestData(requestData) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
+            DataItemIdSet dataItemsToSubscribe = {};
             mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
             mParent->mClientToDataItems.add(mClient, mDataItemSet);
 
@@ -115,7 +114,7 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
                     LOC_LOGd("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                            containerTransfer<DataItemIdSet, list<DataItemId>>(
                                     std::move(dataItemsToSubscribe)),
                             mParent);
                 }
@@ -123,7 +122,7 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         }
         mutable SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        const unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
         const list<DataItemId> diItemlist;
         bool mToRequestData;
     };
@@ -143,11 +142,11 @@ void SystemStatusOsObserver::updateSubscription(
         HandleUpdateSubscriptionReq(SystemStatusOsObserver* parent,
                                     list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(containerTransfer<list<DataItemId>, DataItemIdSet>(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
+            DataItemIdSet dataItemsToSubscribe = {};
+            DataItemIdSet dataItemsToUnsubscribe = {};
             unordered_set<IDataItemObserver*> clients({mClient});
             // below removes clients from all entries keyed with the return of the
             // mClientToDataItems.update() call. If leaving an empty set of clients as the
@@ -162,7 +161,7 @@ void SystemStatusOsObserver::updateSubscription(
                     // corresponding entries, and gets a set of the entries that are
                     // removed from the <DataItemId, IDataItemObserver*> map as a result.
                     mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
+                                                       (DataItemIdSet&)mDataItemSet),
                     clients, &dataItemsToUnsubscribe, nullptr);
             // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
             // new keys added to that map, which are DataItemIds to be subscribed.
@@ -178,7 +177,7 @@ void SystemStatusOsObserver::updateSubscription(
                     mParent->logMe(dataItemsToSubscribe);
 
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                            containerTransfer<DataItemIdSet, list<DataItemId>>(
                                     std::move(dataItemsToSubscribe)),
                             mParent);
                 }
@@ -189,7 +188,7 @@ void SystemStatusOsObserver::updateSubscription(
                     mParent->logMe(dataItemsToUnsubscribe);
 
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                            containerTransfer<DataItemIdSet, list<DataItemId>>(
                                     std::move(dataItemsToUnsubscribe)),
                             mParent);
                 }
@@ -197,7 +196,7 @@ void SystemStatusOsObserver::updateSubscription(
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -215,12 +214,12 @@ void SystemStatusOsObserver::unsubscribe(
         HandleUnsubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(containerTransfer<list<DataItemId>, DataItemIdSet>(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient = {};
+            DataItemIdSet dataItemsUnusedByClient = {};
             unordered_set<IDataItemObserver*> clientToRemove = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
+            DataItemIdSet dataItemsToUnsubscribe = {};
             mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
                                                      &dataItemsUnusedByClient);
             mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
@@ -232,14 +231,14 @@ void SystemStatusOsObserver::unsubscribe(
 
                 // Send unsubscribe to framework
                 mParent->mContext.mSubscriptionObj->unsubscribe(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                        containerTransfer<DataItemIdSet, list<DataItemId>>(
                                   std::move(dataItemsToUnsubscribe)),
                         mParent);
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -257,10 +256,10 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
+            DataItemIdSet diByClient = mParent->mClientToDataItems.getValSet(mClient);
 
             if (!diByClient.empty()) {
-                unordered_set<DataItemId> dataItemsToUnsubscribe;
+                DataItemIdSet dataItemsToUnsubscribe;
                 mParent->mClientToDataItems.remove(mClient);
                 mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
                                                          &dataItemsToUnsubscribe, nullptr);
@@ -273,7 +272,7 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
 
                     // Send unsubscribe to framework
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
+                            containerTransfer<DataItemIdSet, list<DataItemId>>(
                                     std::move(dataItemsToUnsubscribe)),
                             mParent);
                 }
@@ -306,37 +305,28 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
         }
 
         void proc() const {
-            // Update Cache with received data items and prepare
-            // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent = {};
+            // Update Cache with received data items, all of which changed,
+            // and prepare the set of data items to be sent.
+            DataItemIdSet dataItemIdsToBeSent;
             for (auto item : mDiVec) {
-                if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
-                }
+                mParent->updateCache(item);
+                dataItemIdsToBeSent.insert(item->getId());
             }
 
             // Send data item to all subscribed clients
             unordered_set<IDataItemObserver*> clientSet = {};
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
+            for (auto item : mDiVec) {
+                auto clients = mParent->mDataItemToClients.getValSetPtr(item->getId());
                 if (nullptr != clients) {
                     clientSet.insert(clients->begin(), clients->end());
                 }
             }
 
             for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
-                    }
+                auto dataItems = mParent->mClientToDataItems.getValSetPtr(client);
+                if (nullptr != dataItems) {
+                    mParent->sendCachedDataItems(*dataItems & dataItemIdsToBeSent, client);
                 }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
             }
         }
         SystemStatusOsObserver* mParent;
@@ -347,6 +337,14 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
         vector<IDataItemCore*> dataItemVec;
 
         for (auto each : dlist) {
+            // Request systemstatus to record this dataitem in its cache right
+            // here; it is locked for that. If the return is false, SystemStatus
+            // either doesn't handle the item or already has this value of it,
+            // so there is nothing for our clients and it need not be copied.
+            if (!isValidId(each->getId()) || !mSystemStatus->eventDataItemNotify(each)) {
+                LOC_LOGd("DataItem:%d unchanged", each->getId());
+                continue;
+            }
 
             IDataItemCore* di = DataItemsFactoryProxy::createNewDataItem(each);
             if (nullptr == di) {
@@ -364,7 +362,8 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
         }
 
         if (!dataItemVec.empty()) {
-            mContext.mMsgTask->sendMsg(new HandleNotify(this, dataItemVec));
+            mContext.mMsgTask->sendMsg(new HandleNotify(this, dataItemVec),
+                                       LOC_MSG_PRIORITY_BACKGROUND);
         }
     }
 }
@@ -522,7 +521,7 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
  Helpers
 ******************************************************************************/
 void SystemStatusOsObserver::sendCachedDataItems(
-        const unordered_set<DataItemId>& s, IDataItemObserver* to)
+        const DataItemIdSet& s, IDataItemObserver* to)
 {
     if (nullptr == to) {
         LOC_LOGv("client pointer is NULL.");
@@ -532,12 +531,11 @@ void SystemStatusOsObserver::sendCachedDataItems(
         list<IDataItemCore*> dataItems = {};
 
         for (auto each : s) {
-            auto citer = mDataItemCache.find(each);
-            if (citer != mDataItemCache.end()) {
+            if (nullptr != mDataItemCache[each]) {
                 string dv;
-                citer->second->stringify(dv);
+                mDataItemCache[each]->stringify(dv);
                 LOC_LOGi("DataItem: %s >> %s", dv.c_str(), clientName.c_str());
-                dataItems.push_front(citer->second);
+                dataItems.push_back(mDataItemCache[each]);
             }
         }
 
@@ -549,32 +547,18 @@ void SystemStatusOsObserver::sendCachedDataItems(
     }
 }
 
-bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
+void SystemStatusOsObserver::updateCache(IDataItemCore* d)
 {
-    bool dataItemUpdated = false;
-
-    // Request systemstatus to record this dataitem in its cache
-    // if the return is false, it means that SystemStatus is not
-    // handling it, so SystemStatusOsObserver also doesn't.
-    // So it has to be true to proceed.
-    if (nullptr != d && mSystemStatus->eventDataItemNotify(d)) {
-        dataItemUpdated = true;
-        auto citer = mDataItemCache.find(d->getId());
-        if (citer == mDataItemCache.end()) {
-            // New data item; not found in cache
-            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(d);
-            if (nullptr != dataitem) {
-                // Insert in mDataItemCache
-                mDataItemCache.insert(std::make_pair(d->getId(), dataitem));
-            }
-        } else {
-            // Found in cache; Update cache if necessary
-            citer->second->copyFrom(d);
-        }
+    // SystemStatus has already taken d as a change, see notify()
+    IDataItemCore*& cached = mDataItemCache[d->getId()];
+    if (nullptr == cached) {
+        // New data item; not in cache yet
+        cached = DataItemsFactoryProxy::createNewDataItem(d);
+    } else {
+        cached->copyFrom(d);
     }
 
-    LOC_LOGd("DataItem:%d updated:%d", d->getId(), dataItemUpdated);
-    return dataItemUpdated;
+    LOC_LOGd("DataItem:%d updated", d->getId());
 }
 
 } // namespace loc_core
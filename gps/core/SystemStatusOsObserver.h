@@ -56,9 +56,12 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
-typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
-typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
+// DataItemIds are a small dense domain, so their sets are kept as bits
+typedef LocBitSet<DataItemId, MAX_DATA_ITEM_ID_1_1> DataItemIdSet;
+typedef LocUnorderedBitSetMap<IDataItemObserver*, DataItemId, MAX_DATA_ITEM_ID_1_1>
+        ClientToDataItems;
+typedef LocBitSetKeyedSetMap<DataItemId, IDataItemObserver*, MAX_DATA_ITEM_ID_1_1>
+        DataItemToClients;
 typedef unordered_map<DataItemId, int> DataItemIdToInt;
 #ifdef USE_GLIB
 // Cache details of backhaul client requests
@@ -87,7 +90,8 @@ public:
     inline SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask) :
             mSystemStatus(systemstatus), mContext(msgTask, this),
             mAddress("SystemStatusOsObserver"),
-            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID) {}
+            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID),
+            mDataItemCache() {}
 
     // dtor
     ~SystemStatusOsObserver();
@@ -150,7 +154,9 @@ private:
     const string                                     mAddress;
     ClientToDataItems                                mClientToDataItems;
     DataItemToClients                                mDataItemToClients;
-    DataItemIdToCore                                 mDataItemCache;
+    // latest value of each item, allocated on its first update and
+    // copied over in place afterwards
+    IDataItemCore*                                   mDataItemCache[MAX_DATA_ITEM_ID_1_1];
     DataItemIdToInt                                  mActiveRequestCount;
 
     // Cache the subscribe and requestData till subscription obj is obtained
@@ -164,9 +170,12 @@ private:
     void subscribe(const list<DataItemId>& l, IDataItemObserver* client, bool toRequestData);
 
     // Helpers
-    void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
-    bool updateCache(IDataItemCore* d);
-    inline void logMe(const unordered_set<DataItemId>& l) {
+    inline static bool isValidId(DataItemId id) {
+        return id > INVALID_DATA_ITEM_ID && id < MAX_DATA_ITEM_ID_1_1;
+    }
+    void sendCachedDataItems(const DataItemIdSet& s, IDataItemObserver* to);
+    void updateCache(IDataItemCore* d);
+    inline void logMe(const DataItemIdSet& l) {
         IF_LOC_LOGD {
             for (auto id : l) {
                 LOC_LOGD("DataItem %d", id);
@@ -38,9 +38,12 @@ using namespace loc_core;
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   true /*isMaster*/, nullptr, true)
+                   true /*isMaster*/, nullptr, true,
+                   LocContext::getAdapterMsgTask("Loc_geofence"))
 {
     LOC_LOGD("%s]: Constructor", __func__);
+    // has no use for the GnssDataNotification of position reports
+    setDataNotifyConsumer(false);
 
     // at last step, let us inform adapater base that we are done
     // with initialization, e.g.: ready to process handleEngineUpEvent
@@ -59,7 +62,7 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
         if (client == key.client) {
             it = mGeofenceIds.erase(it);
             mLocApi->removeGeofence(hwId, key.id,
-                    new LocApiResponse(*getContext(),
+                    new LocApiTaskResponse(*getContext(), *getMsgTask(),
                     [this, hwId] (LocationError err) {
                 if (LOCATION_ERROR_SUCCESS == err) {
                     auto it2 = mGeofences.find(hwId);
@@ -162,12 +165,14 @@ GeofenceAdapter::restartGeofences()
         mLocApi->addGeofence(object.key.id,
                               options,
                               info,
-                              new LocApiResponseData<LocApiGeofenceData>(*getContext(),
+                              new LocApiTaskResponseData<LocApiGeofenceData>(*getContext(),
+                                                                             *getMsgTask(),
                 [this, object, options, info] (LocationError err, LocApiGeofenceData data) {
             if (LOCATION_ERROR_SUCCESS == err) {
                 if (true == object.paused) {
                     mLocApi->pauseGeofence(data.hwId, object.key.id,
-                            new LocApiResponse(*getContext(), [] (LocationError err ) {}));
+                            new LocApiTaskResponse(*getContext(),
+                                                   *getMsgTask(), [] (LocationError err ) {}));
                 }
                 saveGeofenceItem(object.key.client, object.key.id, data.hwId, options, info);
             }
@@ -242,12 +247,14 @@ GeofenceAdapter::addGeofencesCommand(LocationAPI* client, size_t count, Geofence
                 if (NULL == mIds || NULL == mOptions || NULL == mInfos) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiTaskResponse(*mAdapter.getContext(),
+                                                               *mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
                             mOptions = mOptions, mInfos = mInfos, mIds = mIds, &mApi = mApi,
                             errs, i] (LocationError err ) {
                         mApi.addGeofence(mIds[i], mOptions[i], mInfos[i],
-                        new LocApiResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
+                        new LocApiTaskResponseData<LocApiGeofenceData>(*mAdapter.getContext(),
+                                *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mOptions = mOptions, mClient = mClient,
                         mCount = mCount, mIds = mIds, mInfos = mInfos, errs, i]
                         (LocationError err, LocApiGeofenceData data) {
@@ -344,14 +351,15 @@ GeofenceAdapter::removeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 return;
             }
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiTaskResponse(*mAdapter.getContext(),
+                                                           *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                         &mApi = mApi, errs, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
                         mApi.removeGeofence(hwId, mIds[i],
-                        new LocApiResponse(*mAdapter.getContext(),
+                        new LocApiTaskResponse(*mAdapter.getContext(), *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                         hwId, errs, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
@@ -420,13 +428,16 @@ GeofenceAdapter::pauseGeofencesCommand(LocationAPI* client, size_t count, uint32
                 return;
             }
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiTaskResponse(*mAdapter.getContext(),
+                                                           *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                         &mApi = mApi, errs, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
-                        mApi.pauseGeofence(hwId, mIds[i], new LocApiResponse(*mAdapter.getContext(),
+                        mApi.pauseGeofence(hwId, mIds[i],
+                                new LocApiTaskResponse(*mAdapter.getContext(),
+                                                       *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                         hwId, errs, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
@@ -495,14 +506,16 @@ GeofenceAdapter::resumeGeofencesCommand(LocationAPI* client, size_t count, uint3
                 return;
             }
             for (size_t i=0; i < mCount; ++i) {
-                mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                mApi.addToCallQueue(new LocApiTaskResponse(*mAdapter.getContext(),
+                                                           *mAdapter.getMsgTask(),
                         [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                         &mApi = mApi, errs, i] (LocationError err ) {
                     uint32_t hwId = 0;
                     errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                     if (LOCATION_ERROR_SUCCESS == errs[i]) {
                         mApi.resumeGeofence(hwId, mIds[i],
-                                new LocApiResponse(*mAdapter.getContext(),
+                                new LocApiTaskResponse(*mAdapter.getContext(),
+                                                       *mAdapter.getMsgTask(),
                                 [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, hwId,
                                 errs, mIds = mIds, i] (LocationError err ) {
                             if (LOCATION_ERROR_SUCCESS == err) {
@@ -578,14 +591,16 @@ GeofenceAdapter::modifyGeofencesCommand(LocationAPI* client, size_t count, uint3
                 if (NULL == mIds || NULL == mOptions) {
                     errs[i] = LOCATION_ERROR_INVALID_PARAMETER;
                 } else {
-                    mApi.addToCallQueue(new LocApiResponse(*mAdapter.getContext(),
+                    mApi.addToCallQueue(new LocApiTaskResponse(*mAdapter.getContext(),
+                                                               *mAdapter.getMsgTask(),
                             [&mAdapter = mAdapter, mCount = mCount, mClient = mClient, mIds = mIds,
                             &mApi = mApi, mOptions = mOptions, errs, i] (LocationError err ) {
                         uint32_t hwId = 0;
                         errs[i] = mAdapter.getHwIdFromClient(mClient, mIds[i], hwId);
                         if (LOCATION_ERROR_SUCCESS == errs[i]) {
                             mApi.modifyGeofence(hwId, mIds[i], mOptions[i],
-                                    new LocApiResponse(*mAdapter.getContext(),
+                                    new LocApiTaskResponse(*mAdapter.getContext(),
+                                                           *mAdapter.getMsgTask(),
                                     [&mAdapter = mAdapter, mCount = mCount, mClient = mClient,
                                     mIds = mIds, mOptions = mOptions, hwId, errs, i]
                                     (LocationError err ) {
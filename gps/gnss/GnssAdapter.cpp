@@ -40,7 +40,6 @@
 #include <netdb.h>
 #include <GnssAdapter.h>
 #include <string>
-#include <sstream>
 #include <loc_log.h>
 #include <loc_nmea.h>
 #include <Agps.h>
@@ -144,6 +143,8 @@ GnssAdapter::GnssAdapter() :
     mNativeAgpsHandler(mSystemStatus->getOsObserver(), *this)
 {
     LOC_LOGD("%s]: Constructor %p", __func__, this);
+    setFixConsumer(true);
+    setDataNotifyConsumer(false);
     mLocPositionMode.mode = LOC_POSITION_MODE_INVALID;
 
     pthread_condattr_t condAttr;
@@ -674,6 +675,13 @@ GnssAdapter::convertLocationInfo(GnssLocationInfoNotification& out,
     out.sessionStatus = status;
 }
 
+void
+GnssAdapter::convertLocationInfo(GnssLocationInfoNotification& out, const LocFix& fix)
+{
+    convertLocationInfo(out, fix.mLocationExtended, fix.mStatus);
+    convertLocation(out.location, fix.mLocation, fix.mLocationExtended);
+}
+
 inline uint32_t
 GnssAdapter::convertSuplVersion(const GnssConfigSuplVersion suplVersion)
 {
@@ -2496,6 +2504,7 @@ GnssAdapter::updateClientsEventMask()
     // for proper nmea generation
     LOC_API_ADAPTER_EVENT_MASK_T mask = LOC_API_ADAPTER_BIT_LOC_SYSTEM_INFO |
             LOC_API_ADAPTER_BIT_EVENT_REPORT_INFO;
+    bool dataNotifyConsumer = false;
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (it->second.trackingCb != nullptr ||
             it->second.gnssLocationInfoCb != nullptr ||
@@ -2512,11 +2521,13 @@ GnssAdapter::updateClientsEventMask()
             mask |= LOC_API_ADAPTER_BIT_GNSS_MEASUREMENT;
         }
         if (it->second.gnssDataCb != nullptr) {
+            dataNotifyConsumer = true;
             mask |= LOC_API_ADAPTER_BIT_PARSED_POSITION_REPORT;
             mask |= LOC_API_ADAPTER_BIT_NMEA_1HZ_REPORT;
             updateNmeaMask(mNmeaMask | LOC_NMEA_MASK_DEBUG_V02);
         }
     }
+    setDataNotifyConsumer(dataNotifyConsumer);
 
     /*
     ** For Automotive use cases we need to enable MEASUREMENT, POLY and EPHEMERIS
@@ -3665,38 +3676,29 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                  LocPosTechMask techMask,
                                  GnssDataNotification* pDataNotify,
                                  int msInWeek)
+{
+    reportPositionEvent(LocFix::create(ulpLocation, locationExtended, status, techMask,
+                                       pDataNotify, msInWeek));
+}
+
+void
+GnssAdapter::reportPositionEvent(const LocFixPtr& fix)
 {
     // this position is from QMI LOC API, then send report to engine hub
     // also, send out SPE fix promptly to the clients that have registered
     // with SPE report
     LOC_LOGd("reportPositionEvent, eng type: %d, unpro %d, sess status %d msInWeek %d",
-             locationExtended.locOutputEngType,
-             ulpLocation.unpropagatedPosition, status, msInWeek);
+             fix->mLocationExtended.locOutputEngType,
+             fix->mLocation.unpropagatedPosition, fix->mStatus, fix->mMsInWeek);
 
     struct MsgReportSPEPosition : public LocMsg {
         GnssAdapter& mAdapter;
-        mutable UlpLocation mUlpLocation;
-        mutable GpsLocationExtended mLocationExtended;
-        enum loc_sess_status mStatus;
-        LocPosTechMask mTechMask;
-        mutable GnssDataNotification mDataNotify;
-        int mMsInWeek;
+        const LocFixPtr mFix;
 
-        inline MsgReportSPEPosition(GnssAdapter& adapter,
-                                    const UlpLocation& ulpLocation,
-                                    const GpsLocationExtended& locationExtended,
-                                    enum loc_sess_status status,
-                                    LocPosTechMask techMask,
-                                    GnssDataNotification dataNotify,
-                                    int msInWeek) :
+        inline MsgReportSPEPosition(GnssAdapter& adapter, const LocFixPtr& fix) :
             LocMsg(),
             mAdapter(adapter),
-            mUlpLocation(ulpLocation),
-            mLocationExtended(locationExtended),
-            mStatus(status),
-            mTechMask(techMask),
-            mDataNotify(dataNotify),
-            mMsInWeek(msInWeek) {}
+            mFix(fix) {}
         inline virtual void proc() const {
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
@@ -3704,23 +3706,28 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                 return;
             }
 
-            if (false == mUlpLocation.unpropagatedPosition && mDataNotify.size != 0) {
-                if (mMsInWeek >= 0) {
-                    mAdapter.getDataInformation((GnssDataNotification&)mDataNotify,
-                                                mMsInWeek);
+            const UlpLocation& ulpLocation = mFix->mLocation;
+            const GpsLocationExtended& locationExtended = mFix->mLocationExtended;
+            // only there if a client had gnssDataCb when the fix came in
+            if (false == ulpLocation.unpropagatedPosition && nullptr != mFix->mDataNotify) {
+                // the fix is shared, fill in a copy
+                GnssDataNotification dataNotify = *mFix->mDataNotify;
+                if (mFix->mMsInWeek >= 0) {
+                    mAdapter.getDataInformation(dataNotify, mFix->mMsInWeek);
                 }
-                mAdapter.reportData(mDataNotify);
+                mAdapter.reportData(dataNotify);
             }
 
             if (true == mAdapter.initEngHubProxy()){
                 // send the SPE fix to engine hub
-                mAdapter.mEngHubProxy->gnssReportPosition(mUlpLocation, mLocationExtended, mStatus);
+                mAdapter.mEngHubProxy->gnssReportPosition(ulpLocation, locationExtended,
+                                                          mFix->mStatus);
                 // report out all SPE fix if it is not propagated, even for failed fix
-                if (false == mUlpLocation.unpropagatedPosition) {
+                if (false == ulpLocation.unpropagatedPosition) {
                     EngineLocationInfo engLocationInfo = {};
-                    engLocationInfo.location = mUlpLocation;
-                    engLocationInfo.locationExtended = mLocationExtended;
-                    engLocationInfo.sessionStatus = mStatus;
+                    engLocationInfo.location = ulpLocation;
+                    engLocationInfo.locationExtended = locationExtended;
+                    engLocationInfo.sessionStatus = mFix->mStatus;
 
                     // obtain the VRP based latitude/longitude/altitude for SPE fix
                     computeVRPBasedLla(engLocationInfo.location,
@@ -3733,29 +3740,23 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
 
             // unpropagated report: is only for engine hub to consume and no need
             // to send out to the clients
-            if (true == mUlpLocation.unpropagatedPosition) {
+            if (true == ulpLocation.unpropagatedPosition) {
                 return;
             }
 
             // extract bug report info - this returns true if consumed by systemstatus
             SystemStatus* s = mAdapter.getSystemStatus();
-            if ((nullptr != s) &&
-                    ((LOC_SESS_SUCCESS == mStatus) || (LOC_SESS_INTERMEDIATE == mStatus))){
-                s->eventPosition(mUlpLocation, mLocationExtended);
+            if ((nullptr != s) && ((LOC_SESS_SUCCESS == mFix->mStatus) ||
+                                   (LOC_SESS_INTERMEDIATE == mFix->mStatus))) {
+                s->eventPosition(ulpLocation, locationExtended);
             }
 
-            mAdapter.reportPosition(mUlpLocation, mLocationExtended, mStatus, mTechMask);
+            mAdapter.reportPosition(mFix);
         }
     };
 
     if (mContext != NULL) {
-        GnssDataNotification dataNotifyCopy = {};
-        if (pDataNotify) {
-            dataNotifyCopy = *pDataNotify;
-            dataNotifyCopy.size = sizeof(dataNotifyCopy);
-        }
-        sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
-                                          status, techMask, dataNotifyCopy, msInWeek));
+        emplaceMsg<MsgReportSPEPosition>(LOC_MSG_PRIORITY_HIGH, 0, *this, fix);
     }
 }
 
@@ -3785,7 +3786,7 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
         }
     };
 
-    sendMsg(new MsgReportEnginePositions(*this, count, locationArr));
+    emplaceMsg<MsgReportEnginePositions>(LOC_MSG_PRIORITY_HIGH, 0, *this, count, locationArr);
 }
 
 bool
@@ -3918,18 +3919,18 @@ GnssAdapter::logLatencyInfo()
 // only fused report (when engine hub is enabled) or
 // SPE report (when engine hub is disabled) will reach this function
 void
-GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
-                            const GpsLocationExtended& locationExtended,
-                            enum loc_sess_status status,
-                            LocPosTechMask techMask)
+GnssAdapter::reportPosition(const LocFixPtr& fix)
 {
+    const UlpLocation& ulpLocation = fix->mLocation;
+    const GpsLocationExtended& locationExtended = fix->mLocationExtended;
+    enum loc_sess_status status = fix->mStatus;
+    LocPosTechMask techMask = fix->mTechMask;
     bool reportToGnssClient = needReportForGnssClient(ulpLocation, status, techMask);
     bool reportToFlpClient = needReportForFlpClient(status, techMask);
 
     if (reportToGnssClient || reportToFlpClient) {
-        GnssLocationInfoNotification locationInfo = {};
-        convertLocationInfo(locationInfo, locationExtended, status);
-        convertLocation(locationInfo.location, ulpLocation, locationExtended);
+        const GnssLocationInfoNotification& locationInfo =
+                fix->getLocationInfo(convertLocationInfo);
         logLatencyInfo();
         for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
             if ((reportToFlpClient && isFlpClient(it->second)) ||
@@ -3992,21 +3993,17 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
         bool custom_nmea_gga = (1 == ContextBase::mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED);
         bool isTagBlockGroupingEnabled =
                 (1 == ContextBase::mGps_conf.NMEA_TAG_BLOCK_GROUPING_ENABLED);
-        std::vector<std::string> nmeaArraystr;
         int indexOfGGA = -1;
+        mNmeaPositionBuffer.clear();
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo, generate_nmea,
-                custom_nmea_gga, nmeaArraystr, indexOfGGA, isTagBlockGroupingEnabled);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+                custom_nmea_gga, mNmeaPositionBuffer, indexOfGGA, isTagBlockGroupingEnabled);
+        reportNmea(mNmeaPositionBuffer.data(), mNmeaPositionBuffer.length());
 
         /* DgnssNtrip */
         if (-1 != indexOfGGA && isDgnssNmeaRequired()) {
             mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
-            mStartDgnssNtripParams.nmea = std::move(nmeaArraystr[indexOfGGA]);
+            mStartDgnssNtripParams.nmea.assign(mNmeaPositionBuffer.sentence(indexOfGGA),
+                    mNmeaPositionBuffer.sentenceLength(indexOfGGA));
             bool isLocationValid = (0 != ulpLocation.gpsLocation.latitude) ||
                     (0 != ulpLocation.gpsLocation.longitude);
             checkUpdateDgnssNtrip(isLocationValid);
@@ -4048,21 +4045,28 @@ GnssAdapter::reportEnginePositions(unsigned int count,
     GnssLocationInfoNotification locationInfo[LOC_OUTPUT_ENGINE_COUNT] = {};
     for (unsigned int i = 0; i < count; i++) {
         const EngineLocationInfo* engLocation = (locationArr+i);
+        LocFixPtr fusedFix;
         // if it is fused/default location, call reportPosition maintain legacy behavior
         if ((GPS_LOCATION_EXTENDED_HAS_OUTPUT_ENG_TYPE & engLocation->locationExtended.flags) &&
             (LOC_OUTPUT_ENGINE_FUSED == engLocation->locationExtended.locOutputEngType)) {
-            reportPosition(engLocation->location,
-                           engLocation->locationExtended,
-                           engLocation->sessionStatus,
-                           engLocation->location.tech_mask);
+            fusedFix = LocFix::create(engLocation->location,
+                                      engLocation->locationExtended,
+                                      engLocation->sessionStatus,
+                                      engLocation->location.tech_mask);
+            reportPosition(fusedFix);
         }
 
         if (needReportEnginePositions) {
-            convertLocationInfo(locationInfo[i], engLocation->locationExtended,
-                                engLocation->sessionStatus);
-            convertLocation(locationInfo[i].location,
-                            engLocation->location,
-                            engLocation->locationExtended);
+            if (nullptr != fusedFix) {
+                // converted once for both, if reportPosition had clients for it
+                locationInfo[i] = fusedFix->getLocationInfo(convertLocationInfo);
+            } else {
+                convertLocationInfo(locationInfo[i], engLocation->locationExtended,
+                                    engLocation->sessionStatus);
+                convertLocation(locationInfo[i].location,
+                                engLocation->location,
+                                engLocation->locationExtended);
+            }
         }
     }
 
@@ -4115,145 +4119,143 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     };
 
-    sendMsg(new MsgReportSv(*this, svNotify));
-}
+    // only the newest SV status matters to the clients, so it replaces
+    // a stale one from the same source still queued behind a busy thread,
+    // unless a position report was queued after that one
+    emplaceMsg<MsgReportSv>(LOC_MSG_PRIORITY_HIGH,
+                            LOC_MSG_COALESCE_KEY(this, fromEngineHub ? 1 : 0),
+                            *this, svNotify);
+}
+
+/* "used in fix" masks of the last position, for reportSv: an always empty mask,
+   then GnssSvUsedInPosition and GnssSvMbUsedInPosition field by field */
+enum SvUsedMaskSlot {
+    SV_USED_SLOT_NONE = 0,
+    SV_USED_SLOT_GPS,
+    SV_USED_SLOT_GLO,
+    SV_USED_SLOT_GAL,
+    SV_USED_SLOT_BDS,
+    SV_USED_SLOT_QZSS,
+    SV_USED_SLOT_NAVIC,
+    SV_USED_SLOT_GPS_L1CA,
+    SV_USED_SLOT_GPS_L1C,
+    SV_USED_SLOT_GPS_L2,
+    SV_USED_SLOT_GPS_L5,
+    SV_USED_SLOT_GLO_G1,
+    SV_USED_SLOT_GLO_G2,
+    SV_USED_SLOT_GAL_E1,
+    SV_USED_SLOT_GAL_E5A,
+    SV_USED_SLOT_GAL_E5B,
+    SV_USED_SLOT_BDS_B1I,
+    SV_USED_SLOT_BDS_B1C,
+    SV_USED_SLOT_BDS_B2I,
+    SV_USED_SLOT_BDS_B2AI,
+    SV_USED_SLOT_QZSS_L1CA,
+    SV_USED_SLOT_QZSS_L1S,
+    SV_USED_SLOT_QZSS_L2,
+    SV_USED_SLOT_QZSS_L5,
+    SV_USED_SLOT_SBAS_L1,
+    SV_USED_SLOT_BDS_B2AQ,
+    SV_USED_SLOT_COUNT
+};
+static_assert(sizeof(GnssSvUsedInPosition) ==
+              (SV_USED_SLOT_GPS_L1CA - SV_USED_SLOT_GPS) * sizeof(uint64_t) &&
+              offsetof(GnssSvUsedInPosition, navic_sv_used_ids_mask) ==
+              (SV_USED_SLOT_NAVIC - SV_USED_SLOT_GPS) * sizeof(uint64_t),
+              "SvUsedMaskSlot out of step with GnssSvUsedInPosition");
+static_assert(sizeof(GnssSvMbUsedInPosition) ==
+              (SV_USED_SLOT_COUNT - SV_USED_SLOT_GPS_L1CA) * sizeof(uint64_t) &&
+              offsetof(GnssSvMbUsedInPosition, bds_b2aq_sv_used_ids_mask) ==
+              (SV_USED_SLOT_BDS_B2AQ - SV_USED_SLOT_GPS_L1CA) * sizeof(uint64_t),
+              "SvUsedMaskSlot out of step with GnssSvMbUsedInPosition");
+
+#define SV_TYPE_COUNT (GNSS_SV_TYPE_NAVIC + 1)
+// one per GnssSignalTypeMask bit, and the last one for no or several bits
+#define SIGNAL_INDEX_COUNT (33)
+
+static inline uint32_t signalIndex(GnssSignalTypeMask signalTypeMask) {
+    return (0 != signalTypeMask && 0 == (signalTypeMask & (signalTypeMask - 1))) ?
+            __builtin_ctz(signalTypeMask) : (SIGNAL_INDEX_COUNT - 1);
+}
+
+static struct SvUsedInFixTable {
+    // [multiband][GnssSvType][signal index] to the SvUsedMaskSlot to test
+    uint8_t slot[2][SV_TYPE_COUNT][SIGNAL_INDEX_COUNT];
+    // svId - svIdBase is the 1 based bit in the constellation mask
+    uint16_t svIdBase[SV_TYPE_COUNT];
+
+    inline void setMb(GnssSvType type, GnssSignalTypeMask signal, SvUsedMaskSlot s) {
+        slot[1][type][signalIndex(signal)] = s;
+    }
+    inline void setAll(GnssSvType type, SvUsedMaskSlot s) {
+        memset(slot[0][type], s, SIGNAL_INDEX_COUNT);
+    }
+
+    SvUsedInFixTable() : slot(), svIdBase() {
+        setAll(GNSS_SV_TYPE_GPS, SV_USED_SLOT_GPS);
+        setAll(GNSS_SV_TYPE_GLONASS, SV_USED_SLOT_GLO);
+        setAll(GNSS_SV_TYPE_GALILEO, SV_USED_SLOT_GAL);
+        setAll(GNSS_SV_TYPE_BEIDOU, SV_USED_SLOT_BDS);
+        setAll(GNSS_SV_TYPE_QZSS, SV_USED_SLOT_QZSS);
+        setAll(GNSS_SV_TYPE_NAVIC, SV_USED_SLOT_NAVIC);
+        // NavIC has no per signal mask, it stays on its single band one
+        memset(slot[1][GNSS_SV_TYPE_NAVIC], SV_USED_SLOT_NAVIC, SIGNAL_INDEX_COUNT);
+        setMb(GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1CA, SV_USED_SLOT_GPS_L1CA);
+        setMb(GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L1C, SV_USED_SLOT_GPS_L1C);
+        setMb(GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L2, SV_USED_SLOT_GPS_L2);
+        setMb(GNSS_SV_TYPE_GPS, GNSS_SIGNAL_GPS_L5, SV_USED_SLOT_GPS_L5);
+        setMb(GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G1, SV_USED_SLOT_GLO_G1);
+        setMb(GNSS_SV_TYPE_GLONASS, GNSS_SIGNAL_GLONASS_G2, SV_USED_SLOT_GLO_G2);
+        setMb(GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B1I, SV_USED_SLOT_BDS_B1I);
+        setMb(GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B1C, SV_USED_SLOT_BDS_B1C);
+        setMb(GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B2I, SV_USED_SLOT_BDS_B2I);
+        setMb(GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B2AI, SV_USED_SLOT_BDS_B2AI);
+        setMb(GNSS_SV_TYPE_BEIDOU, GNSS_SIGNAL_BEIDOU_B2AQ, SV_USED_SLOT_BDS_B2AQ);
+        setMb(GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E1, SV_USED_SLOT_GAL_E1);
+        setMb(GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5A, SV_USED_SLOT_GAL_E5A);
+        setMb(GNSS_SV_TYPE_GALILEO, GNSS_SIGNAL_GALILEO_E5B, SV_USED_SLOT_GAL_E5B);
+        setMb(GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L1CA, SV_USED_SLOT_QZSS_L1CA);
+        setMb(GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L1S, SV_USED_SLOT_QZSS_L1S);
+        setMb(GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L2, SV_USED_SLOT_QZSS_L2);
+        setMb(GNSS_SV_TYPE_QZSS, GNSS_SIGNAL_QZSS_L5, SV_USED_SLOT_QZSS_L5);
+
+        // map the svid to respective constellation range 1..xx
+        // then repective constellation svUsedIdMask map correctly to svid
+        svIdBase[GNSS_SV_TYPE_GLONASS] = GLO_SV_PRN_MIN - 1;
+        svIdBase[GNSS_SV_TYPE_BEIDOU] = BDS_SV_PRN_MIN - 1;
+        svIdBase[GNSS_SV_TYPE_GALILEO] = GAL_SV_PRN_MIN - 1;
+        svIdBase[GNSS_SV_TYPE_QZSS] = QZSS_SV_PRN_MIN - 1;
+        svIdBase[GNSS_SV_TYPE_NAVIC] = NAVIC_SV_PRN_MIN - 1;
+    }
+} sSvUsedInFixTable;
 
 void
 GnssAdapter::reportSv(GnssSvNotification& svNotify)
 {
-    int numSv = svNotify.count;
-    uint16_t gnssSvId = 0;
-    uint64_t svUsedIdMask = 0;
-    for (int i=0; i < numSv; i++) {
-        svUsedIdMask = 0;
-        gnssSvId = svNotify.gnssSvs[i].svId;
-        GnssSignalTypeMask signalTypeMask = svNotify.gnssSvs[i].gnssSignalTypeMask;
-        switch (svNotify.gnssSvs[i].type) {
-            case GNSS_SV_TYPE_GPS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    if (mGnssMbSvIdUsedInPosAvail) {
-                        switch (signalTypeMask) {
-                        case GNSS_SIGNAL_GPS_L1CA:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gps_l1ca_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GPS_L1C:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gps_l1c_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GPS_L2:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gps_l2_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GPS_L5:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gps_l5_sv_used_ids_mask;
-                            break;
-                        }
-                    } else {
-                        svUsedIdMask = mGnssSvIdUsedInPosition.gps_sv_used_ids_mask;
-                    }
-                }
-                break;
-            case GNSS_SV_TYPE_GLONASS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    if (mGnssMbSvIdUsedInPosAvail) {
-                        switch (signalTypeMask) {
-                        case GNSS_SIGNAL_GLONASS_G1:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.glo_g1_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GLONASS_G2:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.glo_g2_sv_used_ids_mask;
-                            break;
-                        }
-                    } else {
-                        svUsedIdMask = mGnssSvIdUsedInPosition.glo_sv_used_ids_mask;
-                    }
-                }
-                // map the svid to respective constellation range 1..xx
-                // then repective constellation svUsedIdMask map correctly to svid
-                gnssSvId = gnssSvId - GLO_SV_PRN_MIN + 1;
-                break;
-            case GNSS_SV_TYPE_BEIDOU:
-                if (mGnssSvIdUsedInPosAvail) {
-                    if (mGnssMbSvIdUsedInPosAvail) {
-                        switch (signalTypeMask) {
-                        case GNSS_SIGNAL_BEIDOU_B1I:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.bds_b1i_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_BEIDOU_B1C:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.bds_b1c_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_BEIDOU_B2I:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.bds_b2i_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_BEIDOU_B2AI:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.bds_b2ai_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_BEIDOU_B2AQ:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.bds_b2aq_sv_used_ids_mask;
-                            break;
-                        }
-                    } else {
-                        svUsedIdMask = mGnssSvIdUsedInPosition.bds_sv_used_ids_mask;
-                    }
-                }
-                gnssSvId = gnssSvId - BDS_SV_PRN_MIN + 1;
-                break;
-            case GNSS_SV_TYPE_GALILEO:
-                if (mGnssSvIdUsedInPosAvail) {
-                    if (mGnssMbSvIdUsedInPosAvail) {
-                        switch (signalTypeMask) {
-                        case GNSS_SIGNAL_GALILEO_E1:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gal_e1_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GALILEO_E5A:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gal_e5a_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_GALILEO_E5B:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.gal_e5b_sv_used_ids_mask;
-                            break;
-                        }
-                    } else {
-                        svUsedIdMask = mGnssSvIdUsedInPosition.gal_sv_used_ids_mask;
-                    }
-                }
-                gnssSvId = gnssSvId - GAL_SV_PRN_MIN + 1;
-                break;
-            case GNSS_SV_TYPE_QZSS:
-                if (mGnssSvIdUsedInPosAvail) {
-                    if (mGnssMbSvIdUsedInPosAvail) {
-                        switch (signalTypeMask) {
-                        case GNSS_SIGNAL_QZSS_L1CA:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.qzss_l1ca_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_QZSS_L1S:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.qzss_l1s_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_QZSS_L2:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.qzss_l2_sv_used_ids_mask;
-                            break;
-                        case GNSS_SIGNAL_QZSS_L5:
-                            svUsedIdMask = mGnssMbSvIdUsedInPosition.qzss_l5_sv_used_ids_mask;
-                            break;
-                        }
-                    } else {
-                        svUsedIdMask = mGnssSvIdUsedInPosition.qzss_sv_used_ids_mask;
-                    }
-                }
-                gnssSvId = gnssSvId - QZSS_SV_PRN_MIN + 1;
-                break;
-            case GNSS_SV_TYPE_NAVIC:
-                if (mGnssSvIdUsedInPosAvail) {
-                    svUsedIdMask = mGnssSvIdUsedInPosition.navic_sv_used_ids_mask;
-                }
-                gnssSvId = gnssSvId - NAVIC_SV_PRN_MIN + 1;
-                break;
-            default:
-                svUsedIdMask = 0;
-                break;
+    if (mGnssSvIdUsedInPosAvail) {
+        uint64_t svUsedIdMasks[SV_USED_SLOT_COUNT] = {};
+        memcpy(&svUsedIdMasks[SV_USED_SLOT_GPS], &mGnssSvIdUsedInPosition,
+               sizeof(mGnssSvIdUsedInPosition));
+        if (mGnssMbSvIdUsedInPosAvail) {
+            memcpy(&svUsedIdMasks[SV_USED_SLOT_GPS_L1CA], &mGnssMbSvIdUsedInPosition,
+                   sizeof(mGnssMbSvIdUsedInPosition));
         }
+        const uint8_t (*slots)[SIGNAL_INDEX_COUNT] =
+                sSvUsedInFixTable.slot[mGnssMbSvIdUsedInPosAvail ? 1 : 0];
 
-        // If SV ID was used in previous position fix, then set USED_IN_FIX
-        // flag, else clear the USED_IN_FIX flag.
-        if (svFitsMask(svUsedIdMask, gnssSvId) && (svUsedIdMask & (1ULL << (gnssSvId - 1)))) {
-            svNotify.gnssSvs[i].gnssSvOptionsMask |= GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+        for (uint32_t i = 0; i < svNotify.count; i++) {
+            GnssSv& sv = svNotify.gnssSvs[i];
+            uint32_t type = (sv.type < SV_TYPE_COUNT) ? sv.type : GNSS_SV_TYPE_UNKNOWN;
+            uint64_t svUsedIdMask =
+                    svUsedIdMasks[slots[type][signalIndex(sv.gnssSignalTypeMask)]];
+            // 0 based bit of the SV, wraps around if svId is below the range
+            uint32_t svBit = (uint32_t)sv.svId - sSvUsedInFixTable.svIdBase[type] - 1;
+
+            // If SV ID was used in previous position fix, then set USED_IN_FIX
+            // flag, else clear the USED_IN_FIX flag.
+            if (svBit < 64 && (svUsedIdMask & (1ULL << svBit))) {
+                sv.gnssSvOptionsMask |= GNSS_SV_OPTIONS_USED_IN_FIX_BIT;
+            }
         }
     }
 
@@ -4265,14 +4267,9 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
         !mTimeBasedTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+        mNmeaBuffer.clear();
+        loc_nmea_generate_sv(svNotify, mNmeaBuffer);
+        reportNmea(mNmeaBuffer.data(), mNmeaBuffer.length());
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -4324,7 +4321,7 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         }
     };
 
-    sendMsg(new MsgReportNmea(*this, nmea, length));
+    emplaceMsg<MsgReportNmea>(LOC_MSG_PRIORITY_HIGH, 0, *this, nmea, length);
 }
 
 void
@@ -4376,7 +4373,9 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
         }
     };
 
-    sendMsg(new MsgReportData(*this, dataNotify, msInWeek));
+    if (isDataNotifyConsumer()) {
+        emplaceMsg<MsgReportData>(LOC_MSG_PRIORITY_HIGH, 0, *this, dataNotify, msInWeek);
+    }
 }
 
 void
@@ -4687,24 +4686,24 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     if (0 != gnssMeasurements.gnssMeasNotification.count) {
         struct MsgReportGnssMeasurementData : public LocMsg {
             GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
-            GnssMeasurementsNotification mMeasurementsNotify;
+            const GnssMeasurementsBuffer mMeasurementsNotify;
             inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
-                                                const GnssMeasurements& gnssMeasurements,
-                                                int msInWeek) :
+                                                GnssMeasurementsBuffer&& measurementsNotify) :
                     LocMsg(),
                     mAdapter(adapter),
-                    mMeasurementsNotify(gnssMeasurements.gnssMeasNotification) {
-                if (-1 != msInWeek) {
-                    mAdapter.getAgcInformation(mMeasurementsNotify, msInWeek);
-                }
-            }
+                    mMeasurementsNotify(std::move(measurementsNotify)) {}
             inline virtual void proc() const {
                 mAdapter.reportGnssMeasurementData(mMeasurementsNotify);
             }
         };
 
-        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek));
+        GnssMeasurementsBuffer measurementsNotify =
+                copyMeasurementsNotification(gnssMeasurements.gnssMeasNotification);
+        if (-1 != msInWeek) {
+            getAgcInformation(measurementsNotify, msInWeek);
+        }
+        emplaceMsg<MsgReportGnssMeasurementData>(LOC_MSG_PRIORITY_HIGH, 0,
+                                                 *this, std::move(measurementsNotify));
     }
     mEngHubProxy->gnssReportSvMeasurement(gnssMeasurements.gnssSvMeasurementSet);
     if (mDGnssNeedReport) {
@@ -4712,12 +4711,31 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     }
 }
 
+GnssMeasurementsBuffer
+GnssAdapter::copyMeasurementsNotification(const GnssMeasurementsNotification& in)
+{
+    GnssMeasurementsBuffer out;
+    uint32_t count = std::min(in.count, (uint32_t)GNSS_MEASUREMENTS_MAX);
+    out.size = in.size;
+    out.clock = in.clock;
+    out.measurements.assign(in.measurements, in.measurements + count);
+    return out;
+}
+
 void
-GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measurements)
+GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsBuffer& measurements)
 {
+    // left uninitialized past count, none of it is read
+    GnssMeasurementsNotification measurementsNotify;
+    measurementsNotify.size = measurements.size;
+    measurementsNotify.count = measurements.measurements.size();
+    std::copy(measurements.measurements.begin(), measurements.measurements.end(),
+              measurementsNotify.measurements);
+    measurementsNotify.clock = measurements.clock;
+
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssMeasurementsCb) {
-            it->second.gnssMeasurementsCb(measurements);
+            it->second.gnssMeasurementsCb(measurementsNotify);
         }
     }
 }
@@ -4994,16 +5012,24 @@ void GnssAdapter::injectOdcpi(const Location& location)
     mLocApi->injectPosition(location, true);
 }
 
-// Called in the context of LocTimer thread
-void OdcpiTimer::timeOutCallback()
+void OdcpiTimer::start()
 {
     if (nullptr != mAdapter) {
-        mAdapter->odcpiTimerExpireEvent();
+        mTimerId = mAdapter->odcpiTimerExpireEvent(ODCPI_EXPECTED_INJECTION_TIME_MS);
     }
 }
 
-// Called in the context of LocTimer thread
-void GnssAdapter::odcpiTimerExpireEvent()
+void OdcpiTimer::stop()
+{
+    if (0 != mTimerId) {
+        // no-op if it has just expired, i.e. we are called from odcpiTimerExpire
+        mAdapter->getMsgTask()->cancelMsg(mTimerId);
+        mTimerId = 0;
+    }
+}
+
+// Returns the id of the delayed msg, for OdcpiTimer to cancel it with
+uint64_t GnssAdapter::odcpiTimerExpireEvent(uint32_t delayMs)
 {
     struct MsgOdcpiTimerExpire : public LocMsg {
         GnssAdapter& mAdapter;
@@ -5014,7 +5040,7 @@ void GnssAdapter::odcpiTimerExpireEvent()
             mAdapter.odcpiTimerExpire();
         }
     };
-    sendMsg(new MsgOdcpiTimerExpire(*this));
+    return mMsgTask->sendMsgDelayed(new MsgOdcpiTimerExpire(*this), delayMs);
 }
 void GnssAdapter::odcpiTimerExpire()
 {
@@ -5547,8 +5573,8 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
         return false;
     }
 
-    SystemStatusReports reports = {};
-    systemstatus->getReport(reports, true);
+    SystemStatusSnapshot snapshot = systemstatus->getSnapshot();
+    const SystemStatusReports& reports = *snapshot;
 
     r.size = sizeof(r);
 
@@ -5644,23 +5670,40 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     convertSatelliteInfo(r.mSatelliteInfo, GNSS_SV_TYPE_NAVIC, reports);
     LOC_LOGV("getDebugReport - satellite=%zu", r.mSatelliteInfo.size());
 
+    // msg queue timing, if enabled with MSG_TASK_STATS in gps.conf
+    if (mMsgTask->isStatsEnabled()) {
+        std::string msgTaskStats;
+        mMsgTask->dumpStats(msgTaskStats);
+        size_t lineStart = 0;
+        while (lineStart < msgTaskStats.size()) {
+            size_t lineEnd = msgTaskStats.find('\n', lineStart);
+            if (std::string::npos == lineEnd) {
+                lineEnd = msgTaskStats.size();
+            }
+            LOC_LOGi("getDebugReport - msgTask %.*s", (int)(lineEnd - lineStart),
+                     msgTaskStats.c_str() + lineStart);
+            lineStart = lineEnd + 1;
+        }
+    }
+
     return true;
 }
 
 /* get AGC information from system status and fill it */
 void
-GnssAdapter::getAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek)
+GnssAdapter::getAgcInformation(GnssMeasurementsBuffer& measurements, int msInWeek)
 {
     SystemStatus* systemstatus = getSystemStatus();
 
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        // shared with the other readers, no reports copied
+        SystemStatusSnapshot snapshot = systemstatus->getSnapshot();
+        const SystemStatusReports& reports = *snapshot;
 
         if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
             (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
 
-            for (size_t i = 0; i < measurements.count; i++) {
+            for (size_t i = 0; i < measurements.measurements.size(); i++) {
                 switch (measurements.measurements[i].svType) {
                 case GNSS_SV_TYPE_GPS:
                 case GNSS_SV_TYPE_QZSS:
@@ -5709,8 +5752,9 @@ GnssAdapter::getDataInformation(GnssDataNotification& data, int msInWeek)
 
     LOC_LOGV("%s]: msInWeek=%d", __func__, msInWeek);
     if (nullptr != systemstatus) {
-        SystemStatusReports reports = {};
-        systemstatus->getReport(reports, true);
+        // shared with the other readers, no reports copied
+        SystemStatusSnapshot snapshot = systemstatus->getSnapshot();
+        const SystemStatusReports& reports = *snapshot;
 
         if ((!reports.mRfAndParams.empty()) && (!reports.mTimeAndClock.empty()) &&
             (abs(msInWeek - (int)reports.mTimeAndClock.back().mGpsTowMs) < 2000)) {
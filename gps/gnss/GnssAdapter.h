@@ -40,9 +40,12 @@
 #include <map>
 #include <functional>
 #include <loc_misc_utils.h>
+#include <loc_nmea.h>
 #include <queue>
 #include <NativeAgpsHandler.h>
 #include <unordered_map>
+#include <vector>
+#include <atomic>
 
 #define MAX_URL_LEN 256
 #define NMEA_SENTENCE_MAX_LENGTH 200
@@ -57,34 +60,35 @@ class GnssAdapter;
 
 typedef std::map<LocationSessionKey, LocationOptions> LocationSessionMap;
 typedef std::map<LocationSessionKey, TrackingOptions> TrackingOptionsMap;
+// a measurements report on its way to the clients, holding only the count
+// measurements reported; expanded into a GnssMeasurementsNotification on delivery
+struct GnssMeasurementsBuffer {
+    uint32_t size;
+    GnssMeasurementsClock clock;
+    std::vector<GnssMeasurementsData> measurements;
+};
 
-class OdcpiTimer : public LocTimer {
+// Runs as a delayed msg on the adapter's own MsgTask, so it is only ever
+// touched from the adapter's thread.
+class OdcpiTimer {
 public:
     OdcpiTimer(GnssAdapter* adapter) :
-            LocTimer(), mAdapter(adapter), mActive(false) {}
+            mAdapter(adapter), mTimerId(0) {}
+    inline ~OdcpiTimer() { stop(); }
 
-    inline void start() {
-        mActive = true;
-        LocTimer::start(ODCPI_EXPECTED_INJECTION_TIME_MS, false);
-    }
-    inline void stop() {
-        mActive = false;
-        LocTimer::stop();
-    }
+    void start();
+    void stop();
     inline void restart() {
         stop();
         start();
     }
     inline bool isActive() {
-        return mActive;
+        return 0 != mTimerId;
     }
 
 private:
-    // Override
-    virtual void timeOutCallback() override;
-
     GnssAdapter* mAdapter;
-    bool mActive;
+    uint64_t mTimerId;
 };
 
 typedef struct {
@@ -219,6 +223,11 @@ class GnssAdapter : public LocAdapterBase {
     uint32_t mAfwControlId;
     uint32_t mNmeaMask;
     uint64_t mPrevNmeaRptTimeNsec;
+    // reused for the NMEA of every position report, which gnssNmeaCb, the
+    // NMEA log and the NTRIP GGA all read
+    LocNmeaBuffer mNmeaPositionBuffer;
+    // reused for the NMEA of every SV report
+    LocNmeaBuffer mNmeaBuffer;
     GnssSvIdConfig mGnssSvIdConfig;
     GnssSvTypeConfig mGnssSeconaryBandConfig;
     GnssSvTypeConfig mGnssSvTypeConfig;
@@ -304,6 +313,8 @@ class GnssAdapter : public LocAdapterBase {
     static void convertLocationInfo(GnssLocationInfoNotification& out,
                                     const GpsLocationExtended& locationExtended,
                                     loc_sess_status status);
+    // both of the above, for LocFix::getLocationInfo
+    static void convertLocationInfo(GnssLocationInfoNotification& out, const LocFix& fix);
     static uint16_t getNumSvUsed(uint64_t svUsedIdsMask,
                                  int totalSvCntInThisConstellation);
 
@@ -508,7 +519,7 @@ public:
     void initDefaultAgps();
     bool initEngHubProxy();
     void initCDFWService();
-    void odcpiTimerExpireEvent();
+    uint64_t odcpiTimerExpireEvent(uint32_t delayMs);
 
     /* ==== REPORTS ======================================================================== */
     /* ======== EVENTS ====(Called from QMI/EngineHub Thread)===================================== */
@@ -518,6 +529,7 @@ public:
                                      LocPosTechMask techMask,
                                      GnssDataNotification* pDataNotify = nullptr,
                                      int msInWeek = -1);
+    virtual void reportPositionEvent(const LocFixPtr& fix);
     virtual void reportEnginePositionsEvent(unsigned int count,
                                             EngineLocationInfo* locationArr);
 
@@ -559,10 +571,7 @@ public:
     bool needReportForFlpClient(enum loc_sess_status status, LocPosTechMask techMask);
     bool needToGenerateNmeaReport(const uint32_t &gpsTimeOfWeekMs,
         const struct timespec32_t &apTimeStamp);
-    void reportPosition(const UlpLocation &ulpLocation,
-                        const GpsLocationExtended &locationExtended,
-                        enum loc_sess_status status,
-                        LocPosTechMask techMask);
+    void reportPosition(const LocFixPtr& fix);
     void reportEnginePositions(unsigned int count,
                                const EngineLocationInfo* locationArr);
     void reportSv(GnssSvNotification& svNotify);
@@ -570,7 +579,9 @@ public:
     void reportData(GnssDataNotification& dataNotify);
     bool requestNiNotify(const GnssNiNotification& notify, const void* data,
                          const bool bInformNiAccept);
-    void reportGnssMeasurementData(const GnssMeasurementsNotification& measurements);
+    static GnssMeasurementsBuffer
+            copyMeasurementsNotification(const GnssMeasurementsNotification& in);
+    void reportGnssMeasurementData(const GnssMeasurementsBuffer& measurements);
     void reportGnssSvIdConfig(const GnssSvIdConfig& config);
     void reportGnssSvTypeConfig(const GnssSvTypeConfig& config);
     void reportGnssConfig(uint32_t sessionId, const GnssConfig& gnssConfig);
@@ -600,7 +611,7 @@ public:
     /*======== GNSSDEBUG ================================================================*/
     bool getDebugReport(GnssDebugReport& report);
     /* get AGC information from system status and fill it */
-    void getAgcInformation(GnssMeasurementsNotification& measurements, int msInWeek);
+    void getAgcInformation(GnssMeasurementsBuffer& measurements, int msInWeek);
     /* get Data information from system status and fill it */
     void getDataInformation(GnssDataNotification& data, int msInWeek);
 
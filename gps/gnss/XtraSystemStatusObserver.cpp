@@ -106,7 +106,8 @@ public:
 XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
                                                    const MsgTask* msgTask) :
         mSystemStatusObsrvr(sysStatObs), mMsgTask(msgTask),
-        mGpsLock(-1), mConnections(~0), mXtraThrottle(true),
+        mGpsLock(-1), mIpcReactor(LocIpcReactor::getShared()), mRecver(nullptr),
+        mConnections(~0), mXtraThrottle(true),
         mReqStatusReceived(false),
         mIsConnectivityStatusKnown(false),
         mSender(LocIpc::getLocIpcLocalSender(LOC_IPC_XTRA)),
@@ -115,7 +116,10 @@ XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
     auto recver = LocIpc::getLocIpcLocalRecver(
             make_shared<XtraIpcListener>(sysStatObs, msgTask, *this),
             LOC_IPC_HAL);
-    mIpc.startNonBlockingListening(recver);
+    mRecver = mIpcReactor->add(recver);
+    if (nullptr == mRecver) {
+        LOC_LOGe("failed to listen on %s", LOC_IPC_HAL);
+    }
     mDelayLocTimer.start(100 /*.1 sec*/,  false);
 }
 
@@ -151,20 +155,25 @@ bool XtraSystemStatusObserver::updateConnections(uint64_t allConnections,
         return true;
     }
 
-    stringstream ss;
-    ss << "connection" << endl << mConnections << endl
-            << mNetworkHandle[0].toString() << endl
-            << mNetworkHandle[1].toString() << endl
-            << mNetworkHandle[2].toString() << endl
-            << mNetworkHandle[3].toString() << endl
-            << mNetworkHandle[4].toString() << endl
-            << mNetworkHandle[5].toString() << endl
-            << mNetworkHandle[6].toString() << endl
-            << mNetworkHandle[7].toString() << endl
-            << mNetworkHandle[8].toString() << endl
-            << mNetworkHandle[MAX_NETWORK_HANDLES-1].toString();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    // "connection", mConnections and each network handle, one per line,
+    // gathered from where they are formatted
+    static char header[] = "connection\n";
+    char connections[24];
+    char handles[MAX_NETWORK_HANDLES][40];
+    struct iovec iov[2 + MAX_NETWORK_HANDLES] = {
+        {header, sizeof(header) - 1},
+        {connections, (size_t)snprintf(connections, sizeof(connections), "%" PRIu64 "\n",
+                                       mConnections)}
+    };
+    for (uint8_t i = 0; i < MAX_NETWORK_HANDLES; ++i) {
+        // as NetworkInfoType::toString(), no line end after the last one
+        int len = snprintf(handles[i], sizeof(handles[i]), "%" PRIu64 "%c%u%s",
+                           mNetworkHandle[i].networkHandle, sDelimit,
+                           mNetworkHandle[i].networkType,
+                           (i < MAX_NETWORK_HANDLES - 1) ? "\n" : "");
+        iov[2 + i] = {handles[i], (size_t)len};
+    }
+    return ( LocIpc::send(*mSender, iov, sizeof(iov) / sizeof(iov[0])) );
 }
 
 bool XtraSystemStatusObserver::updateTac(const string& tac) {
@@ -174,11 +183,12 @@ bool XtraSystemStatusObserver::updateTac(const string& tac) {
         return true;
     }
 
-    stringstream ss;
-    ss <<  "tac";
-    ss << " " << tac.c_str();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    static char header[] = "tac ";
+    struct iovec iov[] = {
+        {header, sizeof(header) - 1},
+        {const_cast<char*>(tac.c_str()), strlen(tac.c_str())}
+    };
+    return ( LocIpc::send(*mSender, iov, sizeof(iov) / sizeof(iov[0])) );
 }
 
 bool XtraSystemStatusObserver::updateMccMnc(const string& mccmnc) {
@@ -188,11 +198,12 @@ bool XtraSystemStatusObserver::updateMccMnc(const string& mccmnc) {
         return true;
     }
 
-    stringstream ss;
-    ss <<  "mncmcc";
-    ss << " " << mccmnc.c_str();
-    string s = ss.str();
-    return ( LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size()) );
+    static char header[] = "mncmcc ";
+    struct iovec iov[] = {
+        {header, sizeof(header) - 1},
+        {const_cast<char*>(mccmnc.c_str()), strlen(mccmnc.c_str())}
+    };
+    return ( LocIpc::send(*mSender, iov, sizeof(iov) / sizeof(iov[0])) );
 }
 
 bool XtraSystemStatusObserver::updateXtraThrottle(const bool enabled) {
@@ -277,13 +288,15 @@ void XtraSystemStatusObserver::stopDgnssSource() {
 
 void XtraSystemStatusObserver::updateNmeaToDgnssServer(const string& nmea)
 {
-    stringstream ss;
-    ss <<  "updateDgnssServerNmea" << endl;
-    ss << nmea.data() << endl;
-
-    string s = ss.str();
-    LOC_LOGd("%s", s.data());
-    LocIpc::send(*mSender, (const uint8_t*)s.data(), s.size());
+    static char header[] = "updateDgnssServerNmea\n";
+    static char lineEnd[] = "\n";
+    struct iovec iov[] = {
+        {header, sizeof(header) - 1},
+        {const_cast<char*>(nmea.c_str()), strlen(nmea.c_str())},
+        {lineEnd, sizeof(lineEnd) - 1}
+    };
+    LOC_LOGd("%s%s", header, nmea.c_str());
+    LocIpc::send(*mSender, iov, sizeof(iov) / sizeof(iov[0]));
 }
 
 void XtraSystemStatusObserver::subscribe(bool yes)
@@ -374,5 +387,6 @@ void XtraSystemStatusObserver::notify(const list<IDataItemCore*>& dlist)
             }
         }
     };
-    mMsgTask->sendMsg(new (nothrow) HandleOsObserverUpdateMsg(this, dlist));
+    mMsgTask->sendMsg(new (nothrow) HandleOsObserverUpdateMsg(this, dlist),
+                      LOC_MSG_PRIORITY_BACKGROUND);
 }
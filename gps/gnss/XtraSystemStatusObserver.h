@@ -63,7 +63,7 @@ public :
     XtraSystemStatusObserver(IOsObserver* sysStatObs, const MsgTask* msgTask);
     inline virtual ~XtraSystemStatusObserver() {
         subscribe(false);
-        mIpc.stopNonBlockingListening();
+        mIpcReactor->remove(mRecver);
     }
 
     // IDataItemObserver overrides
@@ -88,7 +88,8 @@ private:
     IOsObserver*    mSystemStatusObsrvr;
     const MsgTask* mMsgTask;
     GnssConfigGpsLock mGpsLock;
-    LocIpc mIpc;
+    shared_ptr<LocIpcReactor> mIpcReactor;
+    const LocIpcRecver* mRecver;
     uint64_t mConnections;
     loc_core::NetworkInfoType mNetworkHandle[MAX_NETWORK_HANDLES];
     string mTac;
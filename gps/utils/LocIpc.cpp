@@ -32,10 +32,21 @@
 #include <errno.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
 #include <loc_misc_utils.h>
 #include <log_util.h>
 #include <LocIpc.h>
+#include <MsgTask.h>
 #include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -60,10 +71,124 @@ namespace loc_util {
 
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
+static inline size_t iovLen(const struct iovec iov[], uint32_t iovCnt) {
+    size_t len = 0;
+    for (uint32_t i = 0; i < iovCnt; i++) {
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+// Header of a message sent in a binary frame, in network byte order. The message
+// follows it, in the same datagram as far as it fits and in as many more as
+// needed; on a stream, frames simply follow each other. A recver tells frames
+// from plain messages by the magic, whose first byte never starts text.
+#define LOC_IPC_FRAME_MAGIC   0xFE4C4950
+#define LOC_IPC_FRAME_VERSION 1
+#define LOC_IPC_FRAME_CRC     0x0001  // crc is set
+struct LocIpcFrameHeader {
+    uint32_t magic;
+    uint8_t version;
+    // later versions may add fields, older recvers skip them
+    uint8_t headerLen;
+    uint16_t flags;
+    // of the message, not counting the header
+    uint32_t length;
+    int32_t msgId;
+    // CRC-32 of the message if LOC_IPC_FRAME_CRC is in flags
+    uint32_t crc;
+};
+static_assert(sizeof(LocIpcFrameHeader) == 20, "LocIpcFrameHeader layout");
+
+static uint32_t crc32(uint32_t crc, const void* data, size_t len) {
+    static const struct Table {
+        uint32_t mEntries[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+                }
+                mEntries[i] = c;
+            }
+        }
+    } sTable;
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (len-- > 0) {
+        crc = sTable.mEntries[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void initFrame(LocIpcFrameHeader& frame, const struct iovec iov[], uint32_t iovCnt,
+                      size_t len, int32_t msgId, bool withCrc) {
+    uint32_t crc = 0;
+    if (withCrc) {
+        for (uint32_t i = 0; i < iovCnt; i++) {
+            crc = crc32(crc, iov[i].iov_base, iov[i].iov_len);
+        }
+    }
+    frame.magic = htonl(LOC_IPC_FRAME_MAGIC);
+    frame.version = LOC_IPC_FRAME_VERSION;
+    frame.headerLen = sizeof(frame);
+    frame.flags = htons(withCrc ? LOC_IPC_FRAME_CRC : 0);
+    frame.length = htonl(len);
+    frame.msgId = htonl(msgId);
+    frame.crc = htonl(crc);
+}
+
+// true if data starts with a frame header, which is then in frame, in host byte order
+static bool parseFrame(const char* data, size_t len, LocIpcFrameHeader& frame) {
+    if (len < sizeof(frame)) {
+        return false;
+    }
+    memcpy(&frame, data, sizeof(frame));
+    frame.magic = ntohl(frame.magic);
+    frame.flags = ntohs(frame.flags);
+    frame.length = ntohl(frame.length);
+    frame.msgId = ntohl(frame.msgId);
+    frame.crc = ntohl(frame.crc);
+    return LOC_IPC_FRAME_MAGIC == frame.magic && frame.version >= LOC_IPC_FRAME_VERSION &&
+            frame.headerLen >= sizeof(frame) && frame.headerLen <= len;
+}
+
+// true if data could be the start of a frame header
+static inline bool isFramePrefix(const char* data, size_t len) {
+    const uint32_t magic = htonl(LOC_IPC_FRAME_MAGIC);
+    return 0 == memcmp(data, &magic, std::min(len, sizeof(magic)));
+}
+
+static void deliverFrame(const LocIpcFrameHeader& frame, const char* msg,
+                         const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb) {
+    if ((frame.flags & LOC_IPC_FRAME_CRC) && crc32(0, msg, frame.length) != frame.crc) {
+        LOC_LOGe("dropped msgId %d of %u bytes for a CRC mismatch", frame.msgId, frame.length);
+    } else {
+        dataCb->onReceiveMsg(msg, frame.length, frame.msgId, &recver);
+    }
+}
+
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                           socklen_t addrlen) const {
     ssize_t rtv = -1;
-    SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
+    struct iovec iov = {const_cast<void*>(buf), len};
+    SOCK_OP_AND_LOG(buf, len, isValid(), rtv,
+                    sendto(&iov, nullptr, 1, flags, destAddr, addrlen, mSendFramed, -1));
+    return rtv;
+}
+ssize_t Sock::send(const struct iovec iov[], uint32_t iovCnt, int flags,
+                   const struct sockaddr *destAddr, socklen_t addrlen, int32_t msgId) const {
+    ssize_t rtv = -1;
+    SOCK_OP_AND_LOG(iov, iovCnt, isValid(), rtv,
+                    sendto(iov, &iovCnt, 1, flags, destAddr, addrlen, mSendFramed, msgId));
+    return rtv;
+}
+ssize_t Sock::sendBatch(const struct iovec msgs[], uint32_t count, int flags,
+                        const struct sockaddr *destAddr, socklen_t addrlen,
+                        int32_t msgId) const {
+    ssize_t rtv = -1;
+    SOCK_OP_AND_LOG(msgs, count, isValid(), rtv,
+                    sendto(msgs, nullptr, count, flags, destAddr, addrlen, mSendFramed, msgId));
     return rtv;
 }
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
@@ -76,57 +201,416 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
                     recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
     return rtv;
 }
-ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                     socklen_t addrlen) const {
-    ssize_t rtv = -1;
-    if (len <= mMaxTxSize) {
-        rtv = ::sendto(mSid, buf, len, flags, destAddr, addrlen);
-    } else {
-        std::string head(LOC_IPC_HEAD + to_string(len));
-        rtv = ::sendto(mSid, head.c_str(), head.length(), flags, destAddr, addrlen);
-        if (rtv > 0) {
-            for (size_t offset = 0; offset < len && rtv > 0; offset += rtv) {
-                rtv = ::sendto(mSid, (char*)buf + offset, min(len - offset, (size_t)mMaxTxSize),
-                               flags, destAddr, addrlen);
+// a message with more buffers than this is not sent by the single message path
+#define SEND_IOV_MAX 8
+
+// Sends the rest of msg, of which a stream socket only took the first done bytes,
+// through signals, which would otherwise leave a part of it out of the stream.
+// Returns the bytes of msg sent in all, or -1.
+static ssize_t sendRest(int sid, const struct msghdr& msg, size_t done, int flags) {
+    vector<struct iovec> rest(msg.msg_iov, msg.msg_iov + msg.msg_iovlen);
+    struct iovec* iov = rest.data();
+    size_t iovCnt = rest.size();
+    for (size_t skip = done; ; ) {
+        while (iovCnt > 0 && skip >= iov->iov_len) {
+            skip -= iov->iov_len;
+            iov++;
+            iovCnt--;
+        }
+        if (0 == iovCnt) {
+            return done;
+        }
+        iov->iov_base = (char*)iov->iov_base + skip;
+        iov->iov_len -= skip;
+        struct msghdr restMsg = msg;
+        restMsg.msg_iov = iov;
+        restMsg.msg_iovlen = iovCnt;
+        ssize_t nSent = ::sendmsg(sid, &restMsg, flags);
+        if (nSent < 0 && EINTR == errno) {
+            skip = 0;
+            continue;
+        }
+        if (nSent <= 0) {
+            return -1;
+        }
+        done += nSent;
+        skip = nSent;
+    }
+}
+
+ssize_t Sock::sendto(const struct iovec msgs[], const uint32_t parts[], uint32_t count,
+                     int flags, const struct sockaddr *destAddr, socklen_t addrlen,
+                     bool framed, int32_t msgId) const {
+    const size_t frameLen = framed ? sizeof(LocIpcFrameHeader) : 0;
+    // one message that fits in a datagram goes out as it is, after its frame if framed
+    if (1 == count) {
+        const uint32_t iovCnt = (nullptr == parts) ? 1 : parts[0];
+        const size_t len = iovLen(msgs, iovCnt);
+        if (len + frameLen <= mMaxTxSize && iovCnt < SEND_IOV_MAX) {
+            struct msghdr msg = {};
+            msg.msg_name = const_cast<struct sockaddr*>(destAddr);
+            msg.msg_namelen = addrlen;
+            msg.msg_iov = const_cast<struct iovec*>(msgs);
+            msg.msg_iovlen = iovCnt;
+            LocIpcFrameHeader frame;
+            struct iovec iovs[SEND_IOV_MAX];
+            if (framed) {
+                initFrame(frame, msgs, iovCnt, len, msgId, mSendCrc);
+                iovs[0] = {&frame, sizeof(frame)};
+                memcpy(&iovs[1], msgs, iovCnt * sizeof(iovs[0]));
+                msg.msg_iov = iovs;
+                msg.msg_iovlen = iovCnt + 1;
             }
-            rtv = (rtv > 0) ? (head.length() + len) : -1;
+            ssize_t rtv = ::sendmsg(mSid, &msg, flags);
+            if (rtv >= 0 && (size_t)rtv < len + frameLen) {
+                rtv = sendRest(mSid, msg, rtv, flags);
+            }
+            return rtv;
         }
     }
+
+    // Otherwise lay out the datagrams of all messages and send them all together.
+    // A longer one is a LOC_IPC_HEAD datagram followed by parts of up to mMaxTxSize,
+    // or if framed, its frame and message split into datagrams of up to mMaxTxSize.
+    vector<struct iovec> iovs;
+    vector<pair<size_t, size_t>> dgrams;  // first iov and number of iovs
+    vector<string> heads;
+    heads.reserve(count);  // the iovs point into them
+    vector<LocIpcFrameHeader> frames;
+    frames.reserve(framed ? count : 0);
+    vector<struct iovec> framedMsg;
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t iovCnt = (nullptr == parts) ? 1 : parts[k];
+        size_t len = iovLen(msgs, iovCnt);
+        const struct iovec* msg = msgs;
+        msgs += iovCnt;
+        if (framed) {
+            frames.resize(frames.size() + 1);
+            initFrame(frames.back(), msg, iovCnt, len, msgId, mSendCrc);
+            framedMsg.assign(1, {&frames.back(), sizeof(LocIpcFrameHeader)});
+            framedMsg.insert(framedMsg.end(), msg, msg + iovCnt);
+            msg = framedMsg.data();
+            iovCnt++;
+            len += frameLen;
+        }
+        if (len <= mMaxTxSize) {
+            dgrams.push_back(make_pair(iovs.size(), (size_t)iovCnt));
+            iovs.insert(iovs.end(), msg, msg + iovCnt);
+            continue;
+        }
+        if (!framed) {
+            heads.push_back(LOC_IPC_HEAD + to_string(len));
+            dgrams.push_back(make_pair(iovs.size(), (size_t)1));
+            iovs.push_back({const_cast<char*>(heads.back().data()), heads.back().length()});
+        }
+        uint32_t i = 0;
+        size_t offset = 0;
+        for (size_t rest = len; rest > 0; ) {
+            size_t first = iovs.size();
+            size_t room = min(rest, (size_t)mMaxTxSize);
+            rest -= room;
+            while (room > 0) {
+                size_t partLen = min(room, msg[i].iov_len - offset);
+                if (partLen > 0) {
+                    iovs.push_back({(char*)msg[i].iov_base + offset, partLen});
+                }
+                offset += partLen;
+                room -= partLen;
+                if (offset == msg[i].iov_len) {
+                    i++;
+                    offset = 0;
+                }
+            }
+            dgrams.push_back(make_pair(first, iovs.size() - first));
+        }
+    }
+
+    vector<struct mmsghdr> hdrs(dgrams.size());
+    for (size_t d = 0; d < dgrams.size(); d++) {
+        hdrs[d].msg_hdr = {};
+        hdrs[d].msg_hdr.msg_name = const_cast<struct sockaddr*>(destAddr);
+        hdrs[d].msg_hdr.msg_namelen = addrlen;
+        hdrs[d].msg_hdr.msg_iov = &iovs[dgrams[d].first];
+        hdrs[d].msg_hdr.msg_iovlen = dgrams[d].second;
+    }
+    ssize_t rtv = 0;
+    for (size_t sent = 0; sent < hdrs.size(); ) {
+        int nSent = ::sendmmsg(mSid, &hdrs[sent], hdrs.size() - sent, flags);
+        // a message may be split over several datagrams, finish it
+        if (nSent < 0 && EINTR == errno && sent > 0) {
+            continue;
+        }
+        if (nSent <= 0) {
+            return -1;
+        }
+        for (int d = 0; d < nSent; d++) {
+            struct mmsghdr& hdr = hdrs[sent + d];
+            ssize_t dgramLen = hdr.msg_len;
+            // a stream socket may have taken only part of it
+            if ((size_t)dgramLen < iovLen(hdr.msg_hdr.msg_iov, hdr.msg_hdr.msg_iovlen)) {
+                dgramLen = sendRest(mSid, hdr.msg_hdr, hdr.msg_len, flags);
+                if (dgramLen < 0) {
+                    return -1;
+                }
+            }
+            rtv += dgramLen;
+        }
+        sent += nSent;
+    }
     return rtv;
 }
+
+// Long messages are reassembled in a buffer of the next power of two size, kept
+// for the next one unless it grew past LONG_RECV_BUF_KEEP.
+#define LONG_RECV_BUF_KEEP (64 * 1024)
+// Longest message a recver takes. The length comes from the peer, and is checked
+// against this before anything is allocated for it.
+#define LONG_RECV_MSG_MAX (16 * 1024 * 1024)
+
+struct Sock::RecvBufs {
+    const uint32_t mSlotSize;
+    const uint32_t mSlots;
+    unique_ptr<char[]> mBuf;
+    unique_ptr<mmsghdr[]> mMsgs;
+    unique_ptr<iovec[]> mIovs;
+    unique_ptr<sockaddr_storage[]> mAddrs;
+    unique_ptr<char[]> mLongBuf;
+    size_t mLongBufSize;
+    // bytes of frames received on a stream but not yet delivered
+    vector<char> mStream;
+
+    inline RecvBufs(uint32_t slotSize, uint32_t slots) :
+            mSlotSize(slotSize), mSlots(slots), mBuf(new char[(size_t)slotSize * slots]),
+            mLongBufSize(0) {
+        if (slots > 1) {
+            mMsgs.reset(new mmsghdr[slots]);
+            mIovs.reset(new iovec[slots]);
+            mAddrs.reset(new sockaddr_storage[slots]);
+        }
+    }
+    inline char* slot(uint32_t i) const { return mBuf.get() + (size_t)mSlotSize * i; }
+    // len is at most LONG_RECV_MSG_MAX
+    inline char* longBuf(size_t len) {
+        if (len > mLongBufSize || nullptr == mLongBuf) {
+            size_t size = mSlotSize;
+            while (size < len && size < LONG_RECV_MSG_MAX) {
+                size <<= 1;
+            }
+            size = std::max(size, len);
+            mLongBuf.reset(new char[size]);
+            mLongBufSize = size;
+        }
+        return mLongBuf.get();
+    }
+    inline void trimLongBuf() {
+        if (mLongBufSize > LONG_RECV_BUF_KEEP) {
+            mLongBuf.reset();
+            mLongBufSize = 0;
+        }
+        if (mStream.empty() && mStream.capacity() > LONG_RECV_BUF_KEEP) {
+            vector<char>().swap(mStream);
+        }
+    }
+};
+
+void Sock::RecvBufsDeleter::operator()(RecvBufs* bufs) const {
+    delete bufs;
+}
+
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
-    std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
-    if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
-            nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+    // only the listening socket itself is batched, not accepted connections
+    const uint32_t batch = (sid == mSid) ? mRecvBatch : 1;
+    if (nullptr == mRecvBufs || mRecvBufs->mSlots < batch) {
+        mRecvBufs.reset(new RecvBufs(mMaxTxSize, batch));
+    }
+    RecvBufs& bufs = *mRecvBufs;
+
+    size_t lens[RECV_BATCH_MAX];
+    int nMsgs = 0;
+    if (batch > 1) {
+        for (uint32_t i = 0; i < batch; i++) {
+            bufs.mIovs[i] = {bufs.slot(i), mMaxTxSize};
+            bufs.mMsgs[i].msg_hdr = {};
+            bufs.mMsgs[i].msg_hdr.msg_iov = &bufs.mIovs[i];
+            bufs.mMsgs[i].msg_hdr.msg_iovlen = 1;
+            if (nullptr != srcAddr) {
+                bufs.mMsgs[i].msg_hdr.msg_name = &bufs.mAddrs[i];
+                bufs.mMsgs[i].msg_hdr.msg_namelen = sizeof(bufs.mAddrs[i]);
+            }
+        }
+        // wait for one datagram, then take those already queued behind it
+        nMsgs = ::recvmmsg(sid, bufs.mMsgs.get(), batch, flags | MSG_WAITFORONE, nullptr);
+        for (int i = 0; i < nMsgs; i++) {
+            lens[i] = bufs.mMsgs[i].msg_len;
+        }
+    } else {
+        ssize_t nBytes = ::recvfrom(sid, bufs.slot(0), mMaxTxSize, flags, srcAddr, addrlen);
+        if (nBytes <= 0) {
+            return nBytes;
+        }
+        lens[nMsgs++] = nBytes;
+    }
+    if (nMsgs <= 0) {
+        return -1;
+    }
+    // frames on a connection arrive in pieces of any size
+    if (sid != mSid && mRecvFramed &&
+            (!bufs.mStream.empty() || isFramePrefix(bufs.slot(0), lens[0]))) {
+        return recvStream(recver, dataCb, sid, flags, lens[0]);
+    }
+
+    ssize_t nBytes = 0;
+    for (int i = 0; i < nMsgs; i++) {
+        const char* data = bufs.slot(i);
+        if (batch > 1 && nullptr != srcAddr && nullptr != addrlen) {
+            *addrlen = std::min(*addrlen, bufs.mMsgs[i].msg_hdr.msg_namelen);
+            memcpy(srcAddr, &bufs.mAddrs[i], *addrlen);
+        }
+
+        LocIpcFrameHeader frame;
+        const bool isFrame = mRecvFramed && parseFrame(data, lens[i], frame);
+        // a message starting in this datagram after a head of headLen
+        size_t msgLen = 0;
+        size_t headLen = 0;
+        if (isFrame) {
+            msgLen = frame.length;
+            headLen = frame.headerLen;
+        } else if (lens[i] >= sizeof(MSG_ABORT) &&
+                   strncmp(data, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+            LOC_LOGi("recvd abort msg.data %s", data);
+            return 0;
+        } else if (lens[i] < sizeof(LOC_IPC_HEAD) - 1 ||
+                   strncmp(data, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
             // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+            dataCb->onReceive(data, lens[i], &recver);
+            nBytes += lens[i];
+            continue;
         } else {
-            // long message
-            size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
-            for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
-                 msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
+            // long message, its parts follow the head
+            string head(data + sizeof(LOC_IPC_HEAD) - 1, lens[i] - (sizeof(LOC_IPC_HEAD) - 1));
+            sscanf(head.c_str(), "%zu", &msgLen);
+            headLen = lens[i];
+        }
+        if (msgLen > LONG_RECV_MSG_MAX) {
+            LOC_LOGe("dropped a msg of %zu bytes, more than %u", msgLen, LONG_RECV_MSG_MAX);
+            continue;
+        }
+
+        const char* msg = data + headLen;
+        size_t msgLenReceived = lens[i] - headLen;
+        if (msgLenReceived < msgLen) {
+            // the rest is in the datagrams that follow; first those in this batch
+            char* longMsg = bufs.longBuf(msgLen);
+            memcpy(longMsg, msg, msgLenReceived);
+            while (msgLenReceived < msgLen && i + 1 < nMsgs) {
+                i++;
+                size_t partLen = std::min(lens[i], msgLen - msgLenReceived);
+                memcpy(longMsg + msgLenReceived, bufs.slot(i), partLen);
+                msgLenReceived += partLen;
+            }
+            ssize_t nRecvd = 1;
+            while (msgLenReceived < msgLen && nRecvd > 0) {
+                nRecvd = ::recvfrom(sid, longMsg + msgLenReceived, msgLen - msgLenReceived,
                                     flags, srcAddr, addrlen);
+                msgLenReceived += (nRecvd > 0) ? nRecvd : 0;
             }
-            if (nBytes > 0) {
-                nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
+            if (nRecvd <= 0) {
+                bufs.trimLongBuf();
+                return nRecvd;
             }
+            msg = longMsg;
+        }
+        if (isFrame) {
+            deliverFrame(frame, msg, recver, dataCb);
+        } else {
+            dataCb->onReceive(msg, msgLen, &recver);
         }
+        nBytes += msgLen;
+        bufs.trimLongBuf();
     }
 
     return nBytes;
 }
+
+ssize_t Sock::recvStream(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                         int sid, int flags, size_t len) const {
+    RecvBufs& bufs = *mRecvBufs;
+    vector<char>& stream = bufs.mStream;
+    stream.insert(stream.end(), bufs.slot(0), bufs.slot(0) + len);
+
+    size_t pos = 0;
+    LocIpcFrameHeader frame;
+    while (stream.size() - pos >= sizeof(frame)) {
+        if (!parseFrame(stream.data() + pos, stream.size() - pos, frame)) {
+            LOC_LOGe("lost track of frames, dropped %zu bytes", stream.size() - pos);
+            pos = stream.size();
+            break;
+        }
+        // headerLen, a uint8_t, is bounded already
+        const size_t frameLen = (size_t)frame.headerLen + frame.length;
+        if (frame.length > LONG_RECV_MSG_MAX) {
+            LOC_LOGe("dropped a frame of %u bytes, more than %u", frame.length, LONG_RECV_MSG_MAX);
+            if (stream.size() - pos >= frameLen) {
+                pos += frameLen;
+                continue;
+            }
+            // read past the rest of it, so the next frame is found where it starts
+            size_t left = frameLen - (stream.size() - pos);
+            ssize_t nRecvd = 1;
+            while (left > 0 && nRecvd > 0) {
+                nRecvd = ::recv(sid, bufs.slot(0), std::min(left, (size_t)bufs.mSlotSize), flags);
+                left -= (nRecvd > 0) ? nRecvd : 0;
+            }
+            stream.clear();
+            bufs.trimLongBuf();
+            return (nRecvd < 0) ? nRecvd : ((left > 0) ? 0 : len);
+        }
+        if (stream.size() - pos < frameLen) {
+            // wait for the rest of this frame, now that its size is known
+            const size_t have = stream.size() - pos;
+            stream.resize(pos + frameLen);
+            ssize_t nRecvd = ::recv(sid, stream.data() + pos + have, frameLen - have,
+                                    flags | MSG_WAITALL);
+            if (nRecvd < (ssize_t)(frameLen - have)) {
+                stream.clear();
+                bufs.trimLongBuf();
+                return (nRecvd < 0) ? nRecvd : 0;
+            }
+        }
+        deliverFrame(frame, stream.data() + pos + frame.headerLen, recver, dataCb);
+        pos += frameLen;
+    }
+    stream.erase(stream.begin(), stream.begin() + pos);
+    bufs.trimLongBuf();
+
+    return len;
+}
 ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen) {
-    return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
+    // never framed, recvers look for it as it is
+    struct iovec iov = {const_cast<char*>(MSG_ABORT), sizeof(MSG_ABORT)};
+    return sendto(&iov, nullptr, 1, flags, destAddr, addrlen, false, -1);
+}
+
+ssize_t LocIpcSender::sendv(const struct iovec iov[], uint32_t iovCnt, int32_t msgId) const {
+    if (1 == iovCnt) {
+        return send((const uint8_t*)iov[0].iov_base, iov[0].iov_len, msgId);
+    }
+    string data;
+    data.reserve(iovLen(iov, iovCnt));
+    for (uint32_t i = 0; i < iovCnt; i++) {
+        data.append((const char*)iov[i].iov_base, iov[i].iov_len);
+    }
+    return send((const uint8_t*)data.data(), data.size(), msgId);
+}
+
+ssize_t LocIpcSender::sendBatch(const struct iovec msgs[], uint32_t count, int32_t msgId) const {
+    ssize_t rtv = 0;
+    for (uint32_t i = 0; i < count && rtv >= 0; i++) {
+        ssize_t sent = send((const uint8_t*)msgs[i].iov_base, msgs[i].iov_len, msgId);
+        rtv = (sent > 0) ? (rtv + sent) : -1;
+    }
+    return rtv;
 }
 
 class LocIpcLocalSender : public LocIpcSender {
@@ -134,10 +618,23 @@ protected:
     shared_ptr<Sock> mSock;
     struct sockaddr_un mAddr;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
-    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        struct iovec iov = {const_cast<uint8_t*>(data), length};
+        return mSock->send(&iov, 1, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
+    }
+    inline virtual ssize_t sendv(const struct iovec iov[], uint32_t iovCnt,
+                                 int32_t msgId) const override {
+        return mSock->send(iov, iovCnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
+    }
+    inline virtual ssize_t sendBatch(const struct iovec msgs[], uint32_t count,
+                                     int32_t msgId) const override {
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
     }
 public:
+    inline virtual bool setFramed(bool withCrc) override {
+        mSock->setSendFramed(withCrc);
+        return true;
+    }
     inline LocIpcLocalSender(const char* name) : LocIpcSender(),
             mSock(nullptr),
             mAddr({.sun_family = AF_UNIX, {}}) {
@@ -168,6 +665,7 @@ protected:
 public:
     inline LocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
             LocIpcLocalSender(name), LocIpcRecver(listener, *this) {
+        mSock->setRecvBatch(Sock::RECV_BATCH_MAX);
 
         if ((unlink(mAddr.sun_path) < 0) && (errno != ENOENT)) {
             LOC_LOGw("unlink socket error. reason:%s", strerror(errno));
@@ -182,6 +680,11 @@ public:
     }
     inline virtual ~LocIpcLocalRecver() { unlink(mAddr.sun_path); }
     inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool acceptFrames() override {
+        mSock->setRecvFramed();
+        return true;
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));
@@ -189,6 +692,603 @@ public:
     }
 };
 
+// Same-host messages through a ring in shared memory, with no copy into and out
+// of the kernel. The sender makes the ring, a memfd, and offers it to the recver
+// together with its eventfd doorbell and one end of a socket pair, the link, in
+// a SHM_RING_HELLO datagram. That goes to a second unix socket, named after the
+// recver's with SHM_HELLO_SUFFIX, which only a shm recver has; a plain local
+// recver never sees it. The recver takes the ring and acknowledges it over the
+// link, and only then does the sender switch from the socket to the ring; the
+// recver takes in what is already on its socket before the first records. The
+// sender writes records into the ring and rings the doorbell only if the recver
+// is waiting on it; the link tells either of them when the other is gone.
+// Messages the ring can't take still go over the socket, after those already in
+// the ring.
+#define SHM_RING_SIZE    (256 * 1024)  // power of two
+#define SHM_RING_MAGIC   0x4C495352
+#define SHM_RECORD_WRAP  0xFFFFFFFF  // record len: the rest of the ring is skipped
+#define SHM_SEND_WAIT_MS 2000  // as long as a local socket send may block
+#define SHM_OFFER_RETRY_MS 1000  // before offering a ring again to no one
+#define SHM_HELLO_SUFFIX ".shm"
+static const char SHM_RING_HELLO[] = "$SHMRING$";
+static const char SHM_LINK_ACCEPT = 'A';
+static const char SHM_LINK_ROOM = 'R';
+
+// the socket rings are offered on, for the recver at name
+static bool shmHelloAddr(const char* name, struct sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    int len = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s%s", name, SHM_HELLO_SUFFIX);
+    return len > 0 && (size_t)len < sizeof(addr.sun_path);
+}
+
+static inline uint64_t shmNowMs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the ring needs lock free atomics");
+
+class ShmRing {
+    struct Header {
+        uint32_t magic;
+        uint32_t size;
+        // bytes ever written and taken, modulo 2^32; positions are these modulo size
+        alignas(64) atomic<uint32_t> head;
+        alignas(64) atomic<uint32_t> tail;
+        // set by the recver before it waits on the doorbell
+        alignas(64) atomic<uint32_t> waiting;
+        // set by the sender before it waits for room on the link
+        alignas(64) atomic<uint32_t> senderWaiting;
+    };
+    struct Record {
+        uint32_t len;
+        int32_t msgId;
+    };
+    Header* mHdr;
+    char* mData;
+    size_t mMapLen;
+    uint32_t mSize;
+    // recver side copy of tail, which the sender could scribble over
+    uint32_t mTail;
+    int mMemFd;
+    int mDoorbell;
+    int mLink;
+    // the recver's end of the link until it is handed over
+    int mPeerLink;
+    // sender side: the recver has acknowledged the ring
+    bool mAccepted;
+    // recver side: what came over the socket before the ring has been taken in
+    bool mSynced;
+
+    inline ShmRing() : mHdr(nullptr), mData(nullptr), mMapLen(0), mSize(0), mTail(0),
+            mMemFd(-1), mDoorbell(-1), mLink(-1), mPeerLink(-1), mAccepted(false),
+            mSynced(false) {}
+    inline bool map(int prot) {
+        void* addr = mmap(nullptr, mMapLen, prot, MAP_SHARED, mMemFd, 0);
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("mmap failed: %s", strerror(errno));
+            return false;
+        }
+        mHdr = (Header*)addr;
+        mData = (char*)addr + sizeof(Header);
+        return true;
+    }
+    static inline uint32_t recordLen(size_t len) {
+        return sizeof(Record) + ((len + sizeof(Record) - 1) & ~(sizeof(Record) - 1));
+    }
+    inline uint32_t freeLen() const {
+        return mSize - (mHdr->head.load(memory_order_relaxed) -
+                        mHdr->tail.load(memory_order_acquire));
+    }
+    // Waits for len free bytes, blocked on the link, which the recver writes to
+    // once it has made room; false if there weren't in time or the recver is gone.
+    bool waitForRoom(uint32_t len) {
+        // the recver may not know yet of the records it is to make room from
+        if (freeLen() >= len) {
+            return true;
+        } else if (!ringDoorbell()) {
+            return false;
+        }
+        const uint64_t deadlineMs = shmNowMs() + SHM_SEND_WAIT_MS;
+        for (;;) {
+            // Say so, then look once more: either this sees the room, or the
+            // recver sees senderWaiting once it has made it, see drain().
+            mHdr->senderWaiting.store(1, memory_order_seq_cst);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (freeLen() >= len) {
+                mHdr->senderWaiting.store(0, memory_order_relaxed);
+                return true;
+            }
+            const uint64_t nowMs = shmNowMs();
+            if (nowMs >= deadlineMs) {
+                return false;
+            }
+            struct pollfd link = {mLink, POLLIN, 0};
+            if (poll(&link, 1, (int)(deadlineMs - nowMs)) < 0 && EINTR != errno) {
+                return false;
+            }
+            if (link.revents & (POLLHUP | POLLERR)) {
+                return false;
+            }
+            if (link.revents & POLLIN) {
+                takeLink();
+            }
+        }
+    }
+    // reads what the recver wrote to the link
+    void takeLink() {
+        char buf[8];
+        ssize_t len;
+        while ((len = ::recv(mLink, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            mAccepted = mAccepted || (nullptr != memchr(buf, SHM_LINK_ACCEPT, len));
+        }
+    }
+public:
+    inline ~ShmRing() {
+        if (nullptr != mHdr) munmap(mHdr, mMapLen);
+        for (int fd : {mMemFd, mDoorbell, mLink, mPeerLink}) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+    inline int getDoorbell() const { return mDoorbell; }
+    inline int getLink() const { return mLink; }
+    // longest message the ring takes
+    inline size_t getMaxLen() const { return mSize / 2 - sizeof(Record); }
+    inline bool isPeerGone() const {
+        struct pollfd link = {mLink, POLLIN, 0};
+        return poll(&link, 1, 0) > 0 && (link.revents & (POLLHUP | POLLERR));
+    }
+
+    // sender side
+    static unique_ptr<ShmRing> create(uint32_t size) {
+        unique_ptr<ShmRing> ring(new ShmRing());
+        int link[2] = {-1, -1};
+        ring->mSize = size;
+        ring->mMapLen = sizeof(Header) + size;
+        ring->mMemFd = syscall(__NR_memfd_create, "LocIpcShmRing", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        ring->mDoorbell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (ring->mMemFd < 0 || ring->mDoorbell < 0 ||
+                ftruncate(ring->mMemFd, ring->mMapLen) < 0 ||
+                // so that the recver can't be made to fault on it
+                fcntl(ring->mMemFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0 ||
+                socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, link) < 0 ||
+                !ring->map(PROT_READ | PROT_WRITE)) {
+            LOC_LOGe("failed to make a ring: %s", strerror(errno));
+            return nullptr;
+        }
+        ring->mLink = link[0];
+        ring->mPeerLink = link[1];
+        new (ring->mHdr) Header();
+        ring->mHdr->magic = SHM_RING_MAGIC;
+        ring->mHdr->size = size;
+        ring->mHdr->waiting.store(1);
+        return ring;
+    }
+    // offers the ring to the recver whose hello socket is at addr
+    bool handOver(int sid, const struct sockaddr_un& addr) {
+        struct iovec iov = {const_cast<char*>(SHM_RING_HELLO), sizeof(SHM_RING_HELLO)};
+        int fds[3] = {mMemFd, mDoorbell, mPeerLink};
+        union {
+            char buf[CMSG_SPACE(sizeof(fds))];
+            struct cmsghdr align;
+        } control = {};
+        struct msghdr msg = {};
+        msg.msg_name = const_cast<struct sockaddr_un*>(&addr);
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        if (::sendmsg(sid, &msg, 0) < 0) {
+            return false;
+        }
+        ::close(mPeerLink);
+        mPeerLink = -1;
+        return true;
+    }
+    // whether the recver has acknowledged the ring yet, without waiting
+    inline bool checkAccepted() {
+        takeLink();
+        return mAccepted;
+    }
+    inline bool isAccepted() const { return mAccepted; }
+    // Writes a record of the len bytes in iov, once there is room for it; false
+    // if there isn't in time or the recver is gone.
+    bool put(const struct iovec iov[], uint32_t iovCnt, size_t len, int32_t msgId) {
+        const uint32_t recLen = recordLen(len);
+        uint32_t head = mHdr->head.load(memory_order_relaxed);
+        uint32_t pos = head & (mSize - 1);
+        const uint32_t toEnd = mSize - pos;
+        if (!waitForRoom(recLen + ((toEnd < recLen) ? toEnd : 0))) {
+            return false;
+        }
+        if (toEnd < recLen) {
+            ((Record*)(mData + pos))->len = SHM_RECORD_WRAP;
+            head += toEnd;
+            pos = 0;
+        }
+        Record* rec = (Record*)(mData + pos);
+        rec->len = len;
+        rec->msgId = msgId;
+        char* data = (char*)(rec + 1);
+        for (uint32_t i = 0; i < iovCnt; i++) {
+            memcpy(data, iov[i].iov_base, iov[i].iov_len);
+            data += iov[i].iov_len;
+        }
+        // ordered against the load of waiting in ringDoorbell(), see drain()
+        mHdr->head.store(head + recLen, memory_order_seq_cst);
+        return true;
+    }
+    // waits until the recver has taken all records; false as put()
+    inline bool waitForEmpty() { return waitForRoom(mSize); }
+    // false if the recver is gone
+    bool ringDoorbell() const {
+        if (0 != mHdr->waiting.exchange(0, memory_order_seq_cst)) {
+            if (isPeerGone()) {
+                return false;
+            }
+            uint64_t one = 1;
+            if (write(mDoorbell, &one, sizeof(one)) < 0) {
+                LOC_LOGw("failed to ring doorbell: %s", strerror(errno));
+            }
+        }
+        return true;
+    }
+
+    // recver side, takes over the fds
+    static unique_ptr<ShmRing> attach(int memFd, int doorbell, int link) {
+        unique_ptr<ShmRing> ring(new ShmRing());
+        ring->mMemFd = memFd;
+        ring->mDoorbell = doorbell;
+        ring->mLink = link;
+        struct stat st = {};
+        int seals = fcntl(memFd, F_GET_SEALS);
+        if (fstat(memFd, &st) < 0 || st.st_size < (off_t)sizeof(Header) ||
+                seals < 0 || !(seals & F_SEAL_SHRINK)) {
+            LOC_LOGe("not a ring memfd");
+            return nullptr;
+        }
+        ring->mMapLen = st.st_size;
+        if (!ring->map(PROT_READ | PROT_WRITE)) {
+            return nullptr;
+        }
+        ring->mSize = ring->mHdr->size;
+        if (SHM_RING_MAGIC != ring->mHdr->magic || ring->mSize < sizeof(Record) * 2 ||
+                0 != (ring->mSize & (ring->mSize - 1)) ||
+                ring->mSize > ring->mMapLen - sizeof(Header)) {
+            LOC_LOGe("ring magic %x size %u are not right", ring->mHdr->magic, ring->mSize);
+            return nullptr;
+        }
+        ring->mTail = ring->mHdr->tail.load();
+        return ring;
+    }
+    // tells the sender it may switch to the ring
+    inline bool accept() const {
+        return 1 == ::send(mLink, &SHM_LINK_ACCEPT, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    // The first time there are records, true: what the sender sent over the
+    // socket before them must be taken in first. It is all queued by then.
+    inline bool needsSync() {
+        if (mSynced || mHdr->head.load(memory_order_acquire) == mTail) {
+            return false;
+        }
+        mSynced = true;
+        return true;
+    }
+    inline void clearDoorbell() const {
+        uint64_t count = 0;
+        while (read(mDoorbell, &count, sizeof(count)) > 0);
+    }
+    // Passes every record in the ring to the listener, straight from the ring; the
+    // record is only taken when the listener returns. False if the ring is bad.
+    bool drain(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+               ssize_t& nBytes) {
+        for (;;) {
+            uint32_t head = mHdr->head.load(memory_order_acquire);
+            if (head - mTail > mSize) {
+                LOC_LOGe("ring head %u is off from tail %u", head, mTail);
+                return false;
+            }
+            while (mTail != head) {
+                const uint32_t pos = mTail & (mSize - 1);
+                const Record* rec = (const Record*)(mData + pos);
+                const uint32_t len = rec->len;
+                if (SHM_RECORD_WRAP == len) {
+                    mTail += mSize - pos;
+                } else if (len > getMaxLen() || recordLen(len) > mSize - pos) {
+                    LOC_LOGe("ring record of %u bytes at %u is bad", len, pos);
+                    return false;
+                } else {
+                    dataCb->onReceiveMsg((const char*)(rec + 1), len, rec->msgId, &recver);
+                    nBytes += len;
+                    mTail += recordLen(len);
+                }
+                mHdr->tail.store(mTail, memory_order_release);
+            }
+            // see waitForRoom()
+            atomic_thread_fence(memory_order_seq_cst);
+            if (0 != mHdr->senderWaiting.load(memory_order_relaxed) &&
+                    0 != mHdr->senderWaiting.exchange(0)) {
+                ::send(mLink, &SHM_LINK_ROOM, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+            }
+            // Say so before going to wait, then look once more: either this sees
+            // the sender's last record, or the sender sees waiting and rings.
+            mHdr->waiting.store(1, memory_order_seq_cst);
+            if (mHdr->head.load(memory_order_seq_cst) == mTail) {
+                return true;
+            }
+        }
+    }
+};
+
+class LocIpcShmSender : public LocIpcLocalSender {
+    mutable mutex mMutex;
+    mutable unique_ptr<ShmRing> mRing;
+    struct sockaddr_un mHelloAddr;
+    // no ring is offered before then, CLOCK_MONOTONIC ms
+    mutable uint64_t mNextOfferMs;
+
+    // With mMutex held; true if there is a ring and the recver has taken it.
+    // Until then messages go over the socket.
+    bool hasRing() const {
+        if (nullptr != mRing && (mRing->isAccepted() || mRing->checkAccepted())) {
+            return true;
+        }
+        if (nullptr != mRing && !mRing->isPeerGone()) {
+            // offered, not taken yet
+            return false;
+        }
+        uint64_t nowMs = shmNowMs();
+        if (nullptr != mRing) {
+            // refused, or the recver went before it took it
+            mRing.reset();
+            mNextOfferMs = nowMs + SHM_OFFER_RETRY_MS;
+        }
+        if (nowMs < mNextOfferMs) {
+            return false;
+        }
+        mRing = ShmRing::create(SHM_RING_SIZE);
+        if (nullptr == mRing || !mRing->handOver(mSock->mSid, mHelloAddr)) {
+            // no shm recver there, at least not yet
+            mRing.reset();
+            mNextOfferMs = nowMs + SHM_OFFER_RETRY_MS;
+        }
+        return false;
+    }
+    ssize_t put(const struct iovec msgs[], const uint32_t parts[], uint32_t count,
+                int32_t msgId) const {
+        lock_guard<mutex> lock(mMutex);
+        ssize_t rtv = 0;
+        bool retried = false;
+        for (uint32_t k = 0; k < count; ) {
+            const uint32_t iovCnt = (nullptr == parts) ? 1 : parts[k];
+            const size_t len = iovLen(msgs, iovCnt);
+            ssize_t sent = -1;
+            if (!hasRing()) {
+                sent = LocIpcLocalSender::sendv(msgs, iovCnt, msgId);
+            } else if (len > mRing->getMaxLen()) {
+                // too long for the ring, so over the socket once the ring is taken
+                if (mRing->waitForEmpty()) {
+                    sent = LocIpcLocalSender::sendv(msgs, iovCnt, msgId);
+                }
+            } else if (mRing->put(msgs, iovCnt, len, msgId)) {
+                sent = len;
+            }
+            if (sent < 0 && !retried && nullptr != mRing && mRing->isPeerGone()) {
+                // the recver is gone, offer a new ring to the one that may be there now
+                // and send over the socket meanwhile
+                mRing.reset();
+                mNextOfferMs = 0;
+                retried = true;
+                continue;
+            }
+            if (sent < 0) {
+                rtv = -1;
+                break;
+            }
+            rtv += sent;
+            msgs += iovCnt;
+            k++;
+        }
+        if (nullptr != mRing && mRing->isAccepted() && !mRing->ringDoorbell()) {
+            // whatever went into the ring since the recver went is lost
+            mRing.reset();
+            rtv = -1;
+        }
+        return rtv;
+    }
+protected:
+    inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        struct iovec iov = {const_cast<uint8_t*>(data), length};
+        return put(&iov, nullptr, 1, msgId);
+    }
+    inline virtual ssize_t sendv(const struct iovec iov[], uint32_t iovCnt,
+                                 int32_t msgId) const override {
+        return put(iov, &iovCnt, 1, msgId);
+    }
+    inline virtual ssize_t sendBatch(const struct iovec msgs[], uint32_t count,
+                                     int32_t msgId) const override {
+        return put(msgs, nullptr, count, msgId);
+    }
+public:
+    inline LocIpcShmSender(const char* name) : LocIpcLocalSender(name), mNextOfferMs(0) {
+        if (nullptr == name || !shmHelloAddr(name, mHelloAddr)) {
+            mNextOfferMs = UINT64_MAX;
+        }
+    }
+};
+
+class LocIpcShmRecver : public LocIpcLocalRecver {
+    // waits on the socket, the hello socket, and the doorbell and link of each ring
+    const int mEpollFd;
+    // where senders offer their rings
+    Sock mHelloSock;
+    struct sockaddr_un mHelloAddr;
+    // by the doorbell and the link fds, used by the listening thread only
+    mutable unordered_map<int, shared_ptr<ShmRing>> mRings;
+
+    inline bool watch(int fd, uint32_t events) const {
+        struct epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        return 0 == epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    void detach(const shared_ptr<ShmRing>& ring) const {
+        for (int fd : {ring->getDoorbell(), ring->getLink()}) {
+            epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+            mRings.erase(fd);
+        }
+    }
+    // Takes in the messages already on the socket; false if it was aborted or
+    // failed.
+    bool takeQueued(ssize_t& nBytes) const {
+        struct pollfd sock = {mSock->mSid, POLLIN, 0};
+        while (poll(&sock, 1, 0) > 0 && (sock.revents & POLLIN)) {
+            ssize_t rtv = LocIpcLocalRecver::recv();
+            if (rtv <= 0) {
+                return false;
+            }
+            nBytes += rtv;
+        }
+        return true;
+    }
+    // false if the ring is bad or the socket was aborted or failed
+    bool drain(const shared_ptr<ShmRing>& ring, ssize_t& nBytes, bool& sockOk) const {
+        if (ring->needsSync() && !takeQueued(nBytes)) {
+            sockOk = false;
+        }
+        return ring->drain(*this, mDataCb, nBytes);
+    }
+    // takes in a SHM_RING_HELLO datagram and the ring it carries
+    void attach() const {
+        char hello[sizeof(SHM_RING_HELLO)];
+        struct iovec iov = {hello, sizeof(hello)};
+        union {
+            char buf[CMSG_SPACE(3 * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        ssize_t len = ::recvmsg(mHelloSock.mSid, &msg, MSG_CMSG_CLOEXEC);
+        if (len < 0) {
+            return;
+        }
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (nullptr == cmsg || SOL_SOCKET != cmsg->cmsg_level || SCM_RIGHTS != cmsg->cmsg_type) {
+            LOC_LOGe("ring hello without a ring");
+            return;
+        }
+        const bool isHello = (sizeof(hello) == (size_t)len && !(msg.msg_flags & MSG_TRUNC) &&
+                              0 == memcmp(hello, SHM_RING_HELLO, sizeof(hello)));
+        const size_t nFds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        int fds[3];
+        if (!isHello || 3 != nFds || (msg.msg_flags & MSG_CTRUNC)) {
+            LOC_LOGe("ring hello of %zd bytes with %zu fds", len, nFds);
+            for (size_t i = 0; i < nFds && i < 3; i++) {
+                memcpy(&fds[i], CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                ::close(fds[i]);
+            }
+            return;
+        }
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+        shared_ptr<ShmRing> ring(ShmRing::attach(fds[0], fds[1], fds[2]));
+        if (nullptr != ring) {
+            if (watch(ring->getDoorbell(), EPOLLIN) && watch(ring->getLink(), EPOLLRDHUP)) {
+                mRings[ring->getDoorbell()] = ring;
+                mRings[ring->getLink()] = ring;
+                // the sender goes on with the socket if this fails
+                if (!ring->accept()) {
+                    LOC_LOGe("failed to accept ring: %s", strerror(errno));
+                    detach(ring);
+                }
+            } else {
+                LOC_LOGe("failed to wait on ring: %s", strerror(errno));
+                epoll_ctl(mEpollFd, EPOLL_CTL_DEL, ring->getDoorbell(), nullptr);
+            }
+        }
+    }
+protected:
+    virtual ssize_t recv() const override {
+        struct epoll_event events[8];
+        int n = epoll_wait(mEpollFd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            return (EINTR == errno) ? 1 : -1;
+        }
+        ssize_t nBytes = 0;
+        bool sockOk = true;
+        for (int i = 0; i < n && sockOk; i++) {
+            const int fd = events[i].data.fd;
+            if (fd == mSock->mSid) {
+                sockOk = takeQueued(nBytes);
+                continue;
+            }
+            if (fd == mHelloSock.mSid) {
+                attach();
+                continue;
+            }
+            auto iter = mRings.find(fd);
+            if (iter == mRings.end()) {
+                continue;
+            }
+            shared_ptr<ShmRing> ring = iter->second;
+            if (fd == ring->getLink()) {
+                if (ring->isPeerGone()) {
+                    // the sender is gone, take what it left first
+                    drain(ring, nBytes, sockOk);
+                    detach(ring);
+                }
+            } else {
+                ring->clearDoorbell();
+                if (!drain(ring, nBytes, sockOk)) {
+                    detach(ring);
+                }
+            }
+        }
+        if (!sockOk) {
+            // aborted, or the socket failed
+            return 0;
+        }
+        // go on listening even if no message came in this time
+        return (nBytes > 0) ? nBytes : 1;
+    }
+public:
+    inline LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
+            LocIpcLocalRecver(listener, name), mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+            mHelloSock(-1) {
+        if (mSock->isValid() && (mEpollFd < 0 || !watch(mSock->mSid, EPOLLIN))) {
+            LOC_LOGe("failed to wait on %s: %s", name, strerror(errno));
+            mSock->close();
+        }
+        // without it, senders just keep to the socket
+        if (mSock->isValid() && shmHelloAddr(name, mHelloAddr)) {
+            unlink(mHelloAddr.sun_path);
+            mHelloSock.mSid = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            if (mHelloSock.isValid() &&
+                    (::bind(mHelloSock.mSid, (struct sockaddr*)&mHelloAddr,
+                            sizeof(mHelloAddr)) < 0 || !watch(mHelloSock.mSid, EPOLLIN))) {
+                LOC_LOGe("failed to take rings at %s: %s", mHelloAddr.sun_path,
+                         strerror(errno));
+                unlink(mHelloAddr.sun_path);
+                mHelloSock.close();
+            }
+        }
+    }
+    inline virtual ~LocIpcShmRecver() {
+        if (mHelloSock.isValid()) unlink(mHelloAddr.sun_path);
+        if (mEpollFd >= 0) ::close(mEpollFd);
+    }
+    inline virtual int getFd() const override { return mEpollFd; }
+};
+
 class LocIpcInetSender : public LocIpcSender {
 protected:
     int mSockType;
@@ -196,10 +1296,23 @@ protected:
     const string mName;
     sockaddr_in mAddr;
     inline virtual bool isOperable() const override { return mSock != nullptr && mSock->isValid(); }
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        struct iovec iov = {const_cast<uint8_t*>(data), length};
+        return mSock->send(&iov, 1, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
+    }
+    virtual ssize_t sendv(const struct iovec iov[], uint32_t iovCnt,
+                          int32_t msgId) const override {
+        return mSock->send(iov, iovCnt, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
+    }
+    virtual ssize_t sendBatch(const struct iovec msgs[], uint32_t count,
+                              int32_t msgId) const override {
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr), msgId);
     }
 public:
+    inline virtual bool setFramed(bool withCrc) override {
+        mSock->setSendFramed(withCrc);
+        return true;
+    }
     inline LocIpcInetSender(const LocIpcInetSender& sender) :
             mSockType(sender.mSockType), mSock(sender.mSock),
             mName(sender.mName), mAddr(sender.mAddr) {
@@ -227,12 +1340,25 @@ class LocIpcInetTcpSender : public LocIpcInetSender {
 protected:
     mutable bool mFirstTime;
 
-    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+    inline void connectOnce() const {
         if (mFirstTime) {
             mFirstTime = false;
             ::connect(mSock->mSid, (const struct sockaddr*)&mAddr, sizeof(mAddr));
         }
-        return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const {
+        connectOnce();
+        return LocIpcInetSender::send(data, length, msgId);
+    }
+    virtual ssize_t sendv(const struct iovec iov[], uint32_t iovCnt,
+                          int32_t msgId) const override {
+        connectOnce();
+        return LocIpcInetSender::sendv(iov, iovCnt, msgId);
+    }
+    virtual ssize_t sendBatch(const struct iovec msgs[], uint32_t count,
+                              int32_t msgId) const override {
+        connectOnce();
+        return LocIpcInetSender::sendBatch(msgs, count, msgId);
     }
 
 public:
@@ -257,6 +1383,11 @@ public:
     }
     inline virtual ~LocIpcInetRecver() {}
     inline virtual const char* getName() const override { return mName.data(); };
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool acceptFrames() override {
+        mSock->setRecvFramed();
+        return true;
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             sockaddr_in loopBackAddr = {.sin_family = AF_INET, .sin_port = htons(mPort),
@@ -288,6 +1419,8 @@ public:
                                int32_t port) :
             LocIpcInetRecver(listener, name, port, SOCK_STREAM), mConnFd(-1) {}
     inline virtual ~LocIpcInetTcpRecver() { if (-1 != mConnFd) ::close(mConnFd);}
+    // it receives on the connection it accepts, not on its socket
+    inline virtual int getFd() const override { return -1; }
 };
 
 class LocIpcInetUdpRecver : public LocIpcInetRecver {
@@ -299,7 +1432,9 @@ protected:
 public:
     inline LocIpcInetUdpRecver(const shared_ptr<ILocIpcListener>& listener, const char* name,
                                 int32_t port) :
-            LocIpcInetRecver(listener, name, port, SOCK_DGRAM) {}
+            LocIpcInetRecver(listener, name, port, SOCK_DGRAM) {
+        mSock->setRecvBatch(Sock::RECV_BATCH_MAX);
+    }
 
     inline virtual ~LocIpcInetUdpRecver() {}
 };
@@ -364,10 +1499,189 @@ void LocIpc::stopBlockingListening(LocIpcRecver& ipcRecver) {
     }
 }
 
+// What the reactor thread and the dispatches it makes need, kept alive by
+// them until the last of them is done.
+struct LocIpcReactor::Core {
+    const int mEpollFd;
+    const int mEventFd;
+    mutex mMutex;
+    unordered_map<const LocIpcRecver*, shared_ptr<Entry>> mEntries;
+
+    inline Core() : mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+            mEventFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+    inline ~Core() {
+        if (mEpollFd >= 0) ::close(mEpollFd);
+        if (mEventFd >= 0) ::close(mEventFd);
+    }
+    inline bool isValid() const { return mEpollFd >= 0 && mEventFd >= 0; }
+    // the recver's socket only reports again once its message is taken
+    inline bool arm(int op, const LocIpcRecver* recver) const {
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = const_cast<LocIpcRecver*>(recver);
+        return 0 == epoll_ctl(mEpollFd, op, recver->getFd(), &event);
+    }
+    static void dispatch(const shared_ptr<Core>& core, const shared_ptr<Entry>& entry);
+};
+
+struct LocIpcReactor::Entry {
+    unique_ptr<LocIpcRecver> mRecver;
+    const MsgTask* const mMsgTask;
+    // held while receiving, so remove() waits for a receive under way
+    recursive_mutex mMutex;
+    bool mRemoved;
+    inline Entry(unique_ptr<LocIpcRecver>& recver, const MsgTask* msgTask) :
+            mRecver(std::move(recver)), mMsgTask(msgTask), mRemoved(false) {}
+};
+
+void LocIpcReactor::Core::dispatch(const shared_ptr<Core>& core, const shared_ptr<Entry>& entry) {
+    lock_guard<recursive_mutex> lock(entry->mMutex);
+    if (!entry->mRemoved) {
+        if (!entry->mRecver->recvData()) {
+            LOC_LOGw("%s stops receiving", entry->mRecver->getName());
+        } else if (!entry->mRemoved) {
+            core->arm(EPOLL_CTL_MOD, entry->mRecver.get());
+        }
+    }
+}
+
+class LocIpcReactorRunnable : public LocRunnable {
+    const shared_ptr<LocIpcReactor::Core> mCore;
+public:
+    inline LocIpcReactorRunnable(const shared_ptr<LocIpcReactor::Core>& core) : mCore(core) {}
+    virtual bool run() override {
+        struct epoll_event events[16];
+        int n = epoll_wait(mCore->mEpollFd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (n < 0) {
+            return EINTR == errno;
+        }
+        for (int i = 0; i < n; i++) {
+            if (nullptr == events[i].data.ptr) {
+                // mEventFd, the reactor is stopped
+                return false;
+            }
+            shared_ptr<LocIpcReactor::Entry> entry;
+            {
+                lock_guard<mutex> lock(mCore->mMutex);
+                auto iter = mCore->mEntries.find((const LocIpcRecver*)events[i].data.ptr);
+                if (iter != mCore->mEntries.end()) {
+                    entry = iter->second;
+                }
+            }
+            if (nullptr == entry) {
+                // removed after epoll_wait() reported it
+            } else if (nullptr != entry->mMsgTask) {
+                shared_ptr<LocIpcReactor::Core> core = mCore;
+                entry->mMsgTask->sendMsg([core, entry] {
+                    LocIpcReactor::Core::dispatch(core, entry);
+                });
+            } else {
+                LocIpcReactor::Core::dispatch(mCore, entry);
+            }
+        }
+        return true;
+    }
+    inline virtual void interrupt() override {
+        uint64_t one = 1;
+        if (write(mCore->mEventFd, &one, sizeof(one)) < 0) {
+            LOC_LOGe("failed to stop reactor: %s", strerror(errno));
+        }
+    }
+};
+
+LocIpcReactor::LocIpcReactor() : mCore(make_shared<Core>()) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (!mCore->isValid() ||
+            0 != epoll_ctl(mCore->mEpollFd, EPOLL_CTL_ADD, mCore->mEventFd, &event) ||
+            !mThread.start("LocIpcReactor", make_shared<LocIpcReactorRunnable>(mCore))) {
+        LOC_LOGe("failed to start reactor: %s", strerror(errno));
+    }
+}
+
+LocIpcReactor::~LocIpcReactor() {
+    mThread.stop();
+    unordered_map<const LocIpcRecver*, shared_ptr<Entry>> entries;
+    {
+        lock_guard<mutex> lock(mCore->mMutex);
+        entries.swap(mCore->mEntries);
+    }
+    for (auto& each : entries) {
+        lock_guard<recursive_mutex> lock(each.second->mMutex);
+        each.second->mRemoved = true;
+    }
+}
+
+shared_ptr<LocIpcReactor> LocIpcReactor::getShared() {
+    static mutex sMutex;
+    static weak_ptr<LocIpcReactor> sReactor;
+    lock_guard<mutex> lock(sMutex);
+    shared_ptr<LocIpcReactor> reactor = sReactor.lock();
+    if (nullptr == reactor) {
+        reactor = make_shared<LocIpcReactor>();
+        sReactor = reactor;
+    }
+    return reactor;
+}
+
+const LocIpcRecver* LocIpcReactor::add(unique_ptr<LocIpcRecver>& ipcRecver,
+                                       const MsgTask* msgTask) {
+    if (!mCore->isValid() || nullptr == ipcRecver || !ipcRecver->isRecvable() ||
+            ipcRecver->getFd() < 0) {
+        LOC_LOGe("ipcRecver is null OR not recvable OR has no fd to wait on");
+        return nullptr;
+    }
+
+    const LocIpcRecver* recver = ipcRecver.get();
+    shared_ptr<Entry> entry = make_shared<Entry>(ipcRecver, msgTask);
+    {
+        lock_guard<mutex> lock(mCore->mMutex);
+        mCore->mEntries[recver] = entry;
+    }
+    // inform that the socket is ready to receive message
+    entry->mRecver->onListenerReady();
+    if (!mCore->arm(EPOLL_CTL_ADD, recver)) {
+        LOC_LOGe("failed to wait on %s: %s", recver->getName(), strerror(errno));
+        lock_guard<mutex> lock(mCore->mMutex);
+        mCore->mEntries.erase(recver);
+        ipcRecver = std::move(entry->mRecver);
+        return nullptr;
+    }
+    return recver;
+}
+
+void LocIpcReactor::remove(const LocIpcRecver* ipcRecver) {
+    shared_ptr<Entry> entry;
+    {
+        lock_guard<mutex> lock(mCore->mMutex);
+        auto iter = mCore->mEntries.find(ipcRecver);
+        if (iter != mCore->mEntries.end()) {
+            entry = iter->second;
+            mCore->mEntries.erase(iter);
+        }
+    }
+    if (nullptr != entry) {
+        epoll_ctl(mCore->mEpollFd, EPOLL_CTL_DEL, ipcRecver->getFd(), nullptr);
+        lock_guard<recursive_mutex> lock(entry->mMutex);
+        entry->mRemoved = true;
+    }
+}
+
 bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, int32_t msgId) {
     return sender.sendData(data, length, msgId);
 }
 
+bool LocIpc::send(LocIpcSender& sender, const struct iovec iov[], uint32_t iovCnt,
+                  int32_t msgId) {
+    return sender.sendData(iov, iovCnt, msgId);
+}
+
+bool LocIpc::sendBatch(LocIpcSender& sender, const struct iovec msgs[], uint32_t count,
+                       int32_t msgId) {
+    return sender.sendDataBatch(msgs, count, msgId);
+}
+
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
@@ -375,6 +1689,13 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcLi
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const char* localSockName) {
+    return make_shared<LocIpcShmSender>(localSockName);
+}
+unique_ptr<LocIpcRecver> LocIpc::getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                                                    const char* localSockName) {
+    return make_unique<LocIpcShmRecver>(listener, localSockName);
+}
 static void* sLibQrtrHandle = nullptr;
 static const char* sLibQrtrName = "libloc_socket.so";
 shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance) {
@@ -34,6 +34,7 @@
 #include <memory>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unordered_set>
 #include <mutex>
@@ -45,6 +46,8 @@ namespace loc_util {
 
 class LocIpcRecver;
 class LocIpcSender;
+class LocIpcReactorRunnable;
+class MsgTask;
 
 class ILocIpcListener {
 protected:
@@ -53,7 +56,15 @@ public:
     // LocIpc client can overwrite this function to get notification
     // when the socket for LocIpc is ready to receive messages.
     inline virtual void onListenerReady() {}
+    // data points into the receiver's own buffer, which is reused for the next
+    // message; it is only valid until this call returns.
     virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver* recver) = 0;
+    // Called instead of onReceive() for a message that came in a binary frame,
+    // with the msgId it was sent with, if the recver accepts frames.
+    inline virtual void onReceiveMsg(const char* data, uint32_t len, int32_t msgId,
+                                     const LocIpcRecver* recver) {
+        onReceive(data, len, recver);
+    }
 };
 
 class LocIpcQrtrWatcher {
@@ -101,6 +112,10 @@ public:
             getLocIpcInetTcpSender(const char* serverName, int32_t port);
     static shared_ptr<LocIpcSender>
             getLocIpcQrtrSender(int service, int instance);
+    // Same host peers passing messages through a ring in shared memory, set up
+    // over a local socket of localSockName; see LocIpc.cpp.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const char* localSockName);
 
     static unique_ptr<LocIpcRecver>
             getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
@@ -111,6 +126,9 @@ public:
     static unique_ptr<LocIpcRecver>
             getLocIpcInetTcpRecver(const shared_ptr<ILocIpcListener>& listener,
                                    const char* serverName, int32_t port);
+    static unique_ptr<LocIpcRecver>
+            getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                               const char* localSockName);
     inline static unique_ptr<LocIpcRecver>
             getLocIpcQrtrRecver(const shared_ptr<ILocIpcListener>& listener,
                                 int service, int instance) {
@@ -147,11 +165,48 @@ public:
     // The function will return true on success, and false on failure.
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
+    // Send out one message made of the iovCnt buffers in iov, in that order,
+    // without first copying them together.
+    static bool send(LocIpcSender& sender, const struct iovec iov[],
+                     uint32_t iovCnt, int32_t msgId = -1);
+    // Send out count messages, one per buffer in msgs, in as few system calls
+    // as the sender can. Returns true only if all of them are sent.
+    static bool sendBatch(LocIpcSender& sender, const struct iovec msgs[],
+                          uint32_t count, int32_t msgId = -1);
 
 private:
     LocThread mThread;
 };
 
+// Serves any number of LocIpcRecvers on one thread, which waits on all of their
+// sockets with epoll, in place of a LocIpc thread blocked on each. A recver's
+// messages are received and passed to its listener on that thread, or on the
+// MsgTask given for it.
+class LocIpcReactor {
+    struct Core;
+    struct Entry;
+    friend class LocIpcReactorRunnable;
+    const shared_ptr<Core> mCore;
+    LocThread mThread;
+public:
+    LocIpcReactor();
+    // stops the thread and all the recvers still served
+    ~LocIpcReactor();
+
+    // The reactor shared within the process, created on first use and gone
+    // once no caller holds it any longer.
+    static shared_ptr<LocIpcReactor> getShared();
+
+    // Takes ipcRecver over and starts serving it. The returned handle is for
+    // remove(); it is nullptr if ipcRecver can't be served this way, in which
+    // case ipcRecver is left with the caller.
+    const LocIpcRecver* add(unique_ptr<LocIpcRecver>& ipcRecver,
+                            const MsgTask* msgTask = nullptr);
+    // Stops serving the recver; its listener is not called once this returns,
+    // unless this is called from within that listener.
+    void remove(const LocIpcRecver* ipcRecver);
+};
+
 /* this is only when client needs to implement Sender / Recver that are not already provided by
    the factor methods prvoided by LocIpc. */
 
@@ -166,10 +221,26 @@ public:
     inline bool sendData(const uint8_t data[], uint32_t length, int32_t msgId) const {
         return isSendable() && (send(data, length, msgId) > 0);
     }
+    inline bool sendData(const struct iovec iov[], uint32_t iovCnt, int32_t msgId) const {
+        return isSendable() && (sendv(iov, iovCnt, msgId) > 0);
+    }
+    inline bool sendDataBatch(const struct iovec msgs[], uint32_t count, int32_t msgId) const {
+        return isSendable() && (sendBatch(msgs, count, msgId) > 0);
+    }
     virtual unique_ptr<LocIpcRecver> getRecver(const shared_ptr<ILocIpcListener>& listener) {
         return nullptr;
     }
     inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) {}
+protected:
+    // By default the buffers are copied together and sent with send(); and the
+    // messages of a batch are sent one send() each.
+    virtual ssize_t sendv(const struct iovec iov[], uint32_t iovCnt, int32_t msgId) const;
+    virtual ssize_t sendBatch(const struct iovec msgs[], uint32_t count, int32_t msgId) const;
+public:
+    // Sends each message from then on in a binary frame carrying its length and
+    // msgId, and a CRC-32 of it if withCrc, for recvers that accept frames.
+    // Returns false if this sender can't frame its messages.
+    inline virtual bool setFramed(bool withCrc) { return false; }
 };
 
 class LocIpcRecver {
@@ -191,23 +262,67 @@ public:
     }
     virtual void abort() const = 0;
     virtual const char* getName() const = 0;
+    // socket to wait on for messages, -1 if recv() can't be waited for this way
+    inline virtual int getFd() const { return -1; }
+    // Takes messages sent in binary frames as well as plain ones, passing the
+    // former to the listener's onReceiveMsg(). Returns false if it can't.
+    inline virtual bool acceptFrames() { return false; }
 };
 
 class Sock {
     static const char MSG_ABORT[];
     static const char LOC_IPC_HEAD[];
     const uint32_t mMaxTxSize;
-    ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
-                   socklen_t addrlen) const;
+    // sends count messages, message i being the next parts[i] buffers of msgs,
+    // or just one of them if parts is null; each in a frame with msgId if framed
+    ssize_t sendto(const struct iovec msgs[], const uint32_t parts[], uint32_t count,
+                   int flags, const struct sockaddr *destAddr, socklen_t addrlen,
+                   bool framed, int32_t msgId) const;
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvStream(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                       int sid, int flags, size_t len) const;
 public:
     int mSid;
-    inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
+private:
+    // Members added past the original layout go after mSid, so that code built
+    // against it keeps finding mSid where it was.
+    // Receive side buffers, kept from one message to the next. Only the one
+    // thread listening on this socket uses them.
+    struct RecvBufs;
+    struct RecvBufsDeleter { void operator()(RecvBufs* bufs) const; };
+    mutable unique_ptr<RecvBufs, RecvBufsDeleter> mRecvBufs;
+    uint32_t mRecvBatch;
+    // binary framing, see setSendFramed() and setRecvFramed()
+    bool mSendFramed;
+    bool mSendCrc;
+    bool mRecvFramed;
+public:
+    inline Sock(int sid, const uint32_t maxTxSize = 8192) :
+            mMaxTxSize(maxTxSize), mSid(sid), mRecvBatch(1), mSendFramed(false),
+            mSendCrc(false), mRecvFramed(false) {}
     inline ~Sock() { close(); }
     inline bool isValid() const { return -1 != mSid; }
+    // For datagram sockets only: drain up to *batch* already queued datagrams
+    // per recvmmsg() call, at the cost of a receive buffer per datagram.
+    static const uint32_t RECV_BATCH_MAX = 8;
+    inline void setRecvBatch(uint32_t batch) {
+        mRecvBatch = (0 == batch) ? 1 : ((batch > RECV_BATCH_MAX) ? RECV_BATCH_MAX : batch);
+    }
+    // Frames the messages sent from then on, see LocIpcSender::setFramed().
+    inline void setSendFramed(bool withCrc) {
+        mSendFramed = true;
+        mSendCrc = withCrc;
+    }
+    // Takes frames among the messages received, see LocIpcRecver::acceptFrames().
+    inline void setRecvFramed() { mRecvFramed = true; }
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                  socklen_t addrlen) const;
+    ssize_t send(const struct iovec iov[], uint32_t iovCnt, int flags,
+                 const struct sockaddr *destAddr, socklen_t addrlen, int32_t msgId = -1) const;
+    ssize_t sendBatch(const struct iovec msgs[], uint32_t count, int flags,
+                      const struct sockaddr *destAddr, socklen_t addrlen,
+                      int32_t msgId = -1) const;
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
@@ -234,6 +349,11 @@ public:
         return "SockRecver";
     }
     inline virtual void abort() const override {}
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool acceptFrames() override {
+        mSock->setRecvFramed();
+        return true;
+    }
 };
 
 }
@@ -30,6 +30,11 @@
 #define __LOC_UNORDERDED_SETMAP_H__
 
 #include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
 #include <loc_pla.h>
 
 #ifdef NO_UNORDERED_SET_OR_MAP
@@ -45,11 +50,182 @@ using std::unordered_map;
 
 namespace loc_util {
 
+// A set of integral or enum values in [0, N), one bit each. It has the part of the
+// unordered_set API that LocUnorderedSetMap and its users need, so it can stand in
+// for unordered_set<T> where T is a small dense domain. Values out of range are
+// never members; inserting them does nothing.
+template <typename T, size_t N>
+class LocBitSet {
+    std::bitset<N> mBits;
+
+    inline static bool inRange(T val) { return static_cast<size_t>(val) < N; }
+    inline LocBitSet(const std::bitset<N>& bits) : mBits(bits) {}
+
+public:
+    class const_iterator {
+        friend class LocBitSet;
+        const std::bitset<N>* mBits;
+        size_t mPos;
+
+        inline const_iterator(const std::bitset<N>* bits, size_t pos) :
+                mBits(bits), mPos(pos) {
+            skip();
+        }
+        inline void skip() {
+            while (mPos < N && !mBits->test(mPos)) {
+                mPos++;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef T reference;
+
+        inline T operator*() const { return static_cast<T>(mPos); }
+        inline const_iterator& operator++() { mPos++; skip(); return *this; }
+        inline const_iterator operator++(int) { const_iterator i = *this; ++*this; return i; }
+        inline bool operator==(const const_iterator& o) const { return mPos == o.mPos; }
+        inline bool operator!=(const const_iterator& o) const { return mPos != o.mPos; }
+    };
+    typedef const_iterator iterator;
+
+    inline LocBitSet() {}
+    inline LocBitSet(std::initializer_list<T> vals) { insert(vals.begin(), vals.end()); }
+    template <typename IN_ITER>
+    inline LocBitSet(IN_ITER first, IN_ITER last) { insert(first, last); }
+
+    inline const_iterator begin() const { return const_iterator(&mBits, 0); }
+    inline const_iterator end() const { return const_iterator(&mBits, N); }
+    inline bool empty() const { return mBits.none(); }
+    inline size_t size() const { return mBits.count(); }
+    inline size_t count(T val) const { return (inRange(val) && mBits.test(val)) ? 1 : 0; }
+    inline const_iterator find(T val) const {
+        return count(val) ? const_iterator(&mBits, static_cast<size_t>(val)) : end();
+    }
+
+    inline std::pair<const_iterator, bool> insert(T val) {
+        if (!inRange(val)) {
+            return std::make_pair(end(), false);
+        }
+        bool inserted = !mBits.test(val);
+        mBits.set(val);
+        return std::make_pair(const_iterator(&mBits, static_cast<size_t>(val)), inserted);
+    }
+    inline const_iterator insert(const_iterator /*hint*/, T val) { return insert(val).first; }
+    template <typename IN_ITER>
+    inline void insert(IN_ITER first, IN_ITER last) {
+        for (; first != last; first++) {
+            insert(*first);
+        }
+    }
+
+    inline size_t erase(T val) {
+        size_t erased = count(val);
+        if (erased) {
+            mBits.reset(val);
+        }
+        return erased;
+    }
+    inline const_iterator erase(const_iterator iter) {
+        mBits.reset(iter.mPos);
+        return const_iterator(&mBits, iter.mPos + 1);
+    }
+    inline void clear() { mBits.reset(); }
+
+    inline bool operator==(const LocBitSet& o) const { return mBits == o.mBits; }
+    inline bool operator!=(const LocBitSet& o) const { return mBits != o.mBits; }
+    inline LocBitSet operator&(const LocBitSet& o) const { return LocBitSet(mBits & o.mBits); }
+    inline LocBitSet operator|(const LocBitSet& o) const { return LocBitSet(mBits | o.mBits); }
+    inline LocBitSet& operator&=(const LocBitSet& o) { mBits &= o.mBits; return *this; }
+    inline LocBitSet& operator|=(const LocBitSet& o) { mBits |= o.mBits; return *this; }
+    // removes every value also in *o*
+    inline LocBitSet& operator-=(const LocBitSet& o) { mBits &= ~o.mBits; return *this; }
+};
+
+// A map keyed by integral or enum values in [0, N), stored in place as an array of
+// N entries. It has the part of the unordered_map API that LocUnorderedSetMap uses.
+// Keys must be in range.
+template <typename KEY, typename V, size_t N>
+class LocBitSetKeyedMap {
+public:
+    typedef std::pair<KEY, V> value_type;
+
+private:
+    value_type mEntries[N];
+    std::bitset<N> mUsed;
+
+public:
+    class iterator {
+        friend class LocBitSetKeyedMap;
+        LocBitSetKeyedMap* mMap;
+        size_t mPos;
+
+        inline iterator(LocBitSetKeyedMap* map, size_t pos) : mMap(map), mPos(pos) {
+            skip();
+        }
+        inline void skip() {
+            while (mPos < N && !mMap->mUsed.test(mPos)) {
+                mPos++;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef LocBitSetKeyedMap::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef value_type* pointer;
+        typedef value_type& reference;
+
+        inline value_type& operator*() const { return mMap->mEntries[mPos]; }
+        inline value_type* operator->() const { return &mMap->mEntries[mPos]; }
+        inline iterator& operator++() { mPos++; skip(); return *this; }
+        inline iterator operator++(int) { iterator i = *this; ++*this; return i; }
+        inline bool operator==(const iterator& o) const { return mPos == o.mPos; }
+        inline bool operator!=(const iterator& o) const { return mPos != o.mPos; }
+    };
+
+    inline LocBitSetKeyedMap() {
+        for (size_t i = 0; i < N; i++) {
+            mEntries[i].first = static_cast<KEY>(i);
+        }
+    }
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, N); }
+    inline bool empty() const { return mUsed.none(); }
+    inline size_t size() const { return mUsed.count(); }
+    inline iterator find(const KEY& key) {
+        size_t i = static_cast<size_t>(key);
+        return (i < N && mUsed.test(i)) ? iterator(this, i) : end();
+    }
+
+    inline V& operator[](const KEY& key) {
+        mUsed.set(key);
+        return mEntries[key].second;
+    }
+
+    inline iterator erase(iterator iter) {
+        mEntries[iter.mPos].second = V();
+        mUsed.reset(iter.mPos);
+        return iterator(this, iter.mPos + 1);
+    }
+    inline size_t erase(const KEY& key) {
+        auto iter = find(key);
+        if (iter == end()) {
+            return 0;
+        }
+        erase(iter);
+        return 1;
+    }
+};
+
 // Trim from *fromSet* any elements that also exist in *rVals*.
 // The optional *goneVals*, if not null, will be populated with removed elements.
-template <typename T>
-inline static void trimSet(unordered_set<T>& fromSet, const unordered_set<T>& rVals,
-                           unordered_set<T>* goneVals) {
+template <typename SET>
+inline static void trimSet(SET& fromSet, const SET& rVals, SET* goneVals) {
     for (auto val : rVals) {
         if (fromSet.erase(val) > 0 && nullptr != goneVals) {
             goneVals->insert(val);
@@ -57,35 +233,82 @@ inline static void trimSet(unordered_set<T>& fromSet, const unordered_set<T>& rV
     }
 }
 
-// this method is destructive to the input unordered_sets.
+template <typename T, size_t N>
+inline static void trimSet(LocBitSet<T, N>& fromSet, const LocBitSet<T, N>& rVals,
+                           LocBitSet<T, N>* goneVals) {
+    if (nullptr != goneVals) {
+        *goneVals |= fromSet & rVals;
+    }
+    fromSet -= rVals;
+}
+
+// this method is destructive to the input sets.
 // the return set is the interset extracted out from the two input sets, *s1* and *s2*.
 // *s1* and *s2* will be left with the intersect removed from them.
-template <typename T>
-static unordered_set<T> removeAndReturnInterset(unordered_set<T>& s1, unordered_set<T>& s2) {
-    unordered_set<T> common = {};
-    for (auto b = s2.begin(); b != s2.end(); b++) {
-        auto a = find(s1.begin(), s1.end(), *b);
+template <typename SET>
+static SET removeAndReturnInterset(SET& s1, SET& s2) {
+    SET common = {};
+    for (auto b = s2.begin(); b != s2.end(); ) {
+        auto a = s1.find(*b);
         if (a != s1.end()) {
             // this is a common item of both l1 and l2, remove from both
             // but after we add to common
             common.insert(*a);
             s1.erase(a);
-            s2.erase(b);
+            b = s2.erase(b);
+        } else {
+            b++;
         }
     }
     return common;
 }
 
-template <typename KEY, typename VAL>
+template <typename T, size_t N>
+static LocBitSet<T, N> removeAndReturnInterset(LocBitSet<T, N>& s1, LocBitSet<T, N>& s2) {
+    LocBitSet<T, N> common = s1 & s2;
+    s1 -= common;
+    s2 -= common;
+    return common;
+}
+
+// Adds all of *vals* into *toSet*.
+template <typename SET>
+inline static void mergeSet(SET& toSet, const SET& vals) {
+    toSet.insert(vals.begin(), vals.end());
+}
+
+template <typename T, size_t N>
+inline static void mergeSet(LocBitSet<T, N>& toSet, const LocBitSet<T, N>& vals) {
+    toSet |= vals;
+}
+
+// Sizing hint for the map; only the hash map takes one.
+template <typename MAP>
+inline static void reserveMap(MAP& /*map*/, size_t /*size*/) {}
+
+#ifndef NO_UNORDERED_SET_OR_MAP
+template <typename K, typename V>
+inline static void reserveMap(unordered_map<K, V>& map, size_t size) {
+    map.reserve(size);
+}
+#endif
+
+// KEY_SET and VAL_SET are the set types used for KEYs and VALs, and MAP maps a KEY
+// to a VAL_SET. Where KEYs or VALs are a small dense domain, LocBitSet and
+// LocBitSetKeyedMap can be given instead, see LocUnorderedBitSetMap and
+// LocBitSetKeyedSetMap below.
+template <typename KEY, typename VAL,
+          typename KEY_SET = unordered_set<KEY>, typename VAL_SET = unordered_set<VAL>,
+          typename MAP = unordered_map<KEY, VAL_SET>>
 class LocUnorderedSetMap {
-    unordered_map<KEY, unordered_set<VAL>> mMap;
+    MAP mMap;
 
     // Trim the VALs pointed to by *iter*, with everything that also exist in *rVals*.
     // If the set becomes empty, remove the map entry. *goneVals*, if not null, records
     // the trimmed VALs.
-    bool trimOrRemove(typename unordered_map<KEY, unordered_set<VAL>>::iterator iter,
-                      const unordered_set<VAL>& rVals, unordered_set<VAL>* goneVals) {
-        trimSet<VAL>(iter->second, rVals, goneVals);
+    bool trimOrRemove(typename MAP::iterator iter,
+                      const VAL_SET& rVals, VAL_SET* goneVals) {
+        trimSet(iter->second, rVals, goneVals);
         bool removeEntry = (iter->second.empty());
         if (removeEntry) {
             mMap.erase(iter);
@@ -96,29 +319,29 @@ class LocUnorderedSetMap {
 public:
     inline LocUnorderedSetMap() {}
     inline LocUnorderedSetMap(size_t size) : LocUnorderedSetMap() {
-        mMap.get_allocator().allocate(size);
+        reserveMap(mMap, size);
     }
 
     inline bool empty() { return mMap.empty(); }
 
     // This gets the raw pointer to the VALs pointed to by *key*
     // If the entry is not in the map, nullptr will be returned.
-    inline unordered_set<VAL>* getValSetPtr(const KEY& key) {
+    inline VAL_SET* getValSetPtr(const KEY& key) {
         auto entry = mMap.find(key);
         return (entry != mMap.end()) ? &(entry->second) : nullptr;
     }
 
     //  This gets a copy of VALs pointed to by *key*
     // If the entry is not in the map, an empty set will be returned.
-    inline unordered_set<VAL> getValSet(const KEY& key) {
+    inline VAL_SET getValSet(const KEY& key) {
         auto entry = mMap.find(key);
-        return (entry != mMap.end()) ? entry->second : unordered_set<VAL>{};
+        return (entry != mMap.end()) ? entry->second : VAL_SET{};
     }
 
     // This gets all the KEYs from the map
-    inline unordered_set<KEY> getKeys() {
-        unordered_set<KEY> keys = {};
-        for (auto entry : mMap) {
+    inline KEY_SET getKeys() {
+        KEY_SET keys = {};
+        for (auto& entry : mMap) {
             keys.insert(entry.first);
         }
         return keys;
@@ -132,13 +355,13 @@ public:
     // that also exist in *rVals*. If the entry is left with an empty set, the entry will
     // be removed. The optional parameters *goneKeys* and *goneVals* will record the KEYs
     // (or entries) and the collapsed VALs removed from the map, respectively.
-    inline void trimOrRemove(unordered_set<KEY>&& keys, const unordered_set<VAL>& rVals,
-                             unordered_set<KEY>* goneKeys, unordered_set<VAL>* goneVals) {
+    inline void trimOrRemove(KEY_SET&& keys, const VAL_SET& rVals,
+                             KEY_SET* goneKeys, VAL_SET* goneVals) {
         trimOrRemove(keys, rVals, goneKeys, goneVals);
     }
 
-    inline void trimOrRemove(unordered_set<KEY>& keys, const unordered_set<VAL>& rVals,
-                             unordered_set<KEY>* goneKeys, unordered_set<VAL>* goneVals) {
+    inline void trimOrRemove(KEY_SET& keys, const VAL_SET& rVals,
+                             KEY_SET* goneKeys, VAL_SET* goneVals) {
         for (auto key : keys) {
             auto iter = mMap.find(key);
             if (iter != mMap.end()) {
@@ -152,12 +375,12 @@ public:
 
     // This adds all VALs from *newVals* to the map entry keyed by *key*. Or if it
     // doesn't exist yet, add the set to the map.
-    bool add(const KEY& key, const unordered_set<VAL>& newVals) {
+    bool add(const KEY& key, const VAL_SET& newVals) {
         bool newEntryAdded = false;
         if (!newVals.empty()) {
             auto iter = mMap.find(key);
             if (iter != mMap.end()) {
-                iter->second.insert(newVals.begin(), newVals.end());
+                mergeSet(iter->second, newVals);
             } else {
                 mMap[key] = newVals;
                 newEntryAdded = true;
@@ -169,13 +392,11 @@ public:
     // This adds to each of entries in the map keyed by *keys* with the VALs in the
     // *enwVals*. If there new entries added (new key in *keys*), *newKeys*, if not
     // null, would be populated with those keys.
-    inline void add(const unordered_set<KEY>& keys, const unordered_set<VAL>&& newVals,
-                    unordered_set<KEY>* newKeys) {
+    inline void add(const KEY_SET& keys, const VAL_SET&& newVals, KEY_SET* newKeys) {
         add(keys, newVals, newKeys);
     }
 
-    inline void add(const unordered_set<KEY>& keys, const unordered_set<VAL>& newVals,
-                    unordered_set<KEY>* newKeys) {
+    inline void add(const KEY_SET& keys, const VAL_SET& newVals, KEY_SET* newKeys) {
         for (auto key : keys) {
             if (add(key, newVals) && nullptr != newKeys) {
                 newKeys->insert(key);
@@ -186,8 +407,8 @@ public:
     // This puts *newVals* into the map keyed by *key*, and returns the VALs that are
     // in effect removed from the keyed VAL set in the map entry.
     // This call would also remove those same VALs from *newVals*.
-    inline unordered_set<VAL> update(const KEY& key, unordered_set<VAL>& newVals) {
-        unordered_set<VAL> goneVals = {};
+    inline VAL_SET update(const KEY& key, VAL_SET& newVals) {
+        VAL_SET goneVals = {};
         if (newVals.empty()) {
             mMap.erase(key);
         } else {
@@ -199,6 +420,16 @@ public:
     }
 };
 
+// VALs in [0, VAL_RANGE): each KEY's VALs are kept as bits.
+template <typename KEY, typename VAL, size_t VAL_RANGE>
+using LocUnorderedBitSetMap = LocUnorderedSetMap<KEY, VAL, unordered_set<KEY>,
+        LocBitSet<VAL, VAL_RANGE>, unordered_map<KEY, LocBitSet<VAL, VAL_RANGE>>>;
+
+// KEYs in [0, KEY_RANGE): the map is an array indexed by KEY.
+template <typename KEY, typename VAL, size_t KEY_RANGE>
+using LocBitSetKeyedSetMap = LocUnorderedSetMap<KEY, VAL, LocBitSet<KEY, KEY_RANGE>,
+        unordered_set<VAL>, LocBitSetKeyedMap<KEY, unordered_set<VAL>, KEY_RANGE>>;
+
 } // namespace loc_util
 
 #endif // #ifndef __LOC_UNORDERDED_SETMAP_H__
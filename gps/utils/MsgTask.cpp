@@ -30,6 +30,19 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <time.h>
+#include <cxxabi.h>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <MsgTask.h>
 #include <msg_q.h>
 #include <log_util.h>
@@ -38,10 +51,20 @@
 
 namespace loc_util {
 
+class LocMsgPool;
+struct LocMsgProducer;
+
 class MTRunnable : public LocRunnable {
     const void* mQ;
+    // freed along with mQ, once the msgs still queued are
+    LocMsgTaskState* const mState;
+    std::vector<void*> mBatch;
+
+    // runs the msg of a dequeued envelope, or its replacement, and frees it
+    void run(LocMsgEnvelope* env);
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    inline MTRunnable(const void* q, LocMsgTaskState* state, uint32_t drainBatchSize) :
+        mQ(q), mState(state), mBatch(drainBatchSize > 1 ? drainBatchSize : 0) {}
     virtual ~MTRunnable();
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
@@ -56,24 +79,886 @@ public:
     virtual void interrupt() override;
 };
 
-static void LocMsgDestroy(void* msg) {
-    delete (LocMsg*)msg;
+// What the msg_q holds for each LocMsg sent. A LocMsg is laid out and
+// allocated exactly as the code that built it, prebuilt or not, expects; all
+// MsgTask keeps about it lives here. The msgs of emplaceMsg() are built right
+// behind their envelope, in the same block.
+struct alignas(std::max_align_t) LocMsgEnvelope {
+    const LocMsg* mMsg;
+    // newer msg of the same coalescing key to run instead of mMsg, set by the
+    // sending thread; taken() once the MsgTask thread has taken the envelope
+    std::atomic<LocMsgEnvelope*> mReplacement;
+    // the msg_q's, plus the producer's while it is the last one it queued
+    std::atomic<uint32_t> mRefs;
+    LocMsgPool* mPool;          // nullptr if the block is not to be recycled
+    // nullptr for MsgTask's own msgs and for the replacements
+    LocMsgProducer* mProducer;
+    uint64_t mCoalesceKey;
+    uint64_t mQueuedAtNs;       // CLOCK_MONOTONIC, 0 if stats were off
+    uint32_t mSizeClass;
+    LocMsgPriority mPriority;
+    bool mInline;               // mMsg was built in storage()
+
+    inline LocMsgEnvelope() :
+        mMsg(nullptr), mReplacement(nullptr), mRefs(1), mPool(nullptr), mProducer(nullptr),
+        mCoalesceKey(0), mQueuedAtNs(0), mSizeClass(0), mPriority(LOC_MSG_PRIORITY_NORMAL),
+        mInline(false) {}
+
+    inline void* storage() { return this + 1; }
+    static inline LocMsgEnvelope* fromStorage(void* storage) {
+        return static_cast<LocMsgEnvelope*>(storage) - 1;
+    }
+    static inline LocMsgEnvelope* taken() {
+        static char marker;
+        return reinterpret_cast<LocMsgEnvelope*>(&marker);
+    }
+    // the replacement to run instead of mMsg, if any; no other can be set
+    // afterwards
+    inline LocMsgEnvelope* take() {
+        LocMsgEnvelope* replacement = mReplacement.exchange(taken(), std::memory_order_acq_rel);
+        return (taken() != replacement) ? replacement : nullptr;
+    }
+};
+
+// Power of 2 size classes from 128 bytes to 64 KB, envelope included, each
+// with a few free slots. Blocks are taken by any sending thread and given
+// back by the MsgTask thread once the message is processed, each with one
+// atomic exchange on a slot, so no sender ever waits for another. Every
+// block handed out holds a reference on the pool, so it outlives its
+// MsgTask until the last message is freed.
+class LocMsgPool {
+    static const uint32_t kMinClassShift = 7;
+    static const uint32_t kClassCount = 10;
+    static const uint32_t kMaxFreePerClass = 8;
+
+    std::atomic<LocMsgEnvelope*> mFree[kClassCount][kMaxFreePerClass];
+    std::atomic<int32_t> mRefs;
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
+
+    inline ~LocMsgPool() {
+        for (uint32_t i = 0; i < kClassCount; i++) {
+            for (uint32_t j = 0; j < kMaxFreePerClass; j++) {
+                ::operator delete(mFree[i][j].load());
+            }
+        }
+    }
+
+    inline void unref() {
+        if (1 == mRefs.fetch_sub(1)) {
+            delete this;
+        }
+    }
+
+public:
+    inline LocMsgPool() : mFree(), mRefs(1), mHits(0), mMisses(0) {}
+
+    // drops the owner's reference
+    inline void release() { unref(); }
+
+    inline LocMsgPoolStats getStats() const {
+        return { mHits.load(), mMisses.load() };
+    }
+
+    // an envelope followed by size bytes of storage, all of it cleared but
+    // the storage
+    LocMsgEnvelope* alloc(size_t size) {
+        size_t total = sizeof(LocMsgEnvelope) + size;
+        uint32_t sizeClass = 0;
+        while (sizeClass < kClassCount && ((size_t)1 << (sizeClass + kMinClassShift)) < total) {
+            sizeClass++;
+        }
+
+        LocMsgEnvelope* env = nullptr;
+        if (sizeClass < kClassCount) {
+            for (uint32_t i = 0; i < kMaxFreePerClass && nullptr == env; i++) {
+                if (nullptr != mFree[sizeClass][i].load(std::memory_order_relaxed)) {
+                    env = mFree[sizeClass][i].exchange(nullptr, std::memory_order_acquire);
+                }
+            }
+        }
+
+        if (nullptr != env) {
+            mHits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            mMisses.fetch_add(1, std::memory_order_relaxed);
+            env = static_cast<LocMsgEnvelope*>(::operator new((sizeClass < kClassCount) ?
+                    ((size_t)1 << (sizeClass + kMinClassShift)) : total));
+        }
+
+        new (env) LocMsgEnvelope();
+        // blocks too big for any class are not recycled
+        if (sizeClass < kClassCount) {
+            env->mPool = this;
+            env->mSizeClass = sizeClass;
+            mRefs++;
+        }
+        return env;
+    }
+
+    void recycle(LocMsgEnvelope* env) {
+        uint32_t sizeClass = env->mSizeClass;
+        for (uint32_t i = 0; i < kMaxFreePerClass && nullptr != env; i++) {
+            LocMsgEnvelope* empty = nullptr;
+            if (mFree[sizeClass][i].compare_exchange_strong(
+                    empty, env, std::memory_order_release, std::memory_order_relaxed)) {
+                env = nullptr;
+            }
+        }
+        ::operator delete(env);
+        unref();
+    }
+};
+
+static_assert((int)LOC_MSG_PRIORITY_HIGH == (int)eMSG_Q_LANE_HIGH &&
+              (int)LOC_MSG_PRIORITY_NORMAL == (int)eMSG_Q_LANE_NORMAL &&
+              (int)LOC_MSG_PRIORITY_BACKGROUND == (int)eMSG_Q_LANE_BACKGROUND &&
+              (int)LOC_MSG_PRIORITY_COUNT == (int)eMSG_Q_LANE_COUNT,
+              "LocMsgPriority must map 1:1 onto msg_q_lane_type");
+
+// drops a reference on the block of env, recycling it with the last one
+static inline void LocMsgUnref(LocMsgEnvelope* env) {
+    if (1 != env->mRefs.fetch_sub(1, std::memory_order_acq_rel)) {
+        return;
+    }
+    LocMsgPool* pool = env->mPool;
+    if (nullptr != pool) {
+        pool->recycle(env);
+    } else {
+        ::operator delete(env);
+    }
+}
+
+// frees the msg of env, and drops the reference the msg_q had on it
+static inline void LocMsgFree(LocMsgEnvelope* env) {
+    if (env->mInline) {
+        env->mMsg->~LocMsg();
+    } else {
+        delete env->mMsg;
+    }
+    LocMsgUnref(env);
+}
+
+// What the scheduler keeps about one thread sending to one MsgTask. Only that
+// thread uses it, but for the count of its envelopes still queued, which the
+// MsgTask thread drops. The last of them to let go frees it.
+struct LocMsgProducer {
+    // 1 for the sending thread, plus 1 per envelope queued
+    std::atomic<uint32_t> mRefs;
+    msg_q_lane_type mLane;
+    // the last envelope queued, holding a reference on it, if it has a
+    // coalescing key; nullptr otherwise
+    LocMsgEnvelope* mLast;
+    const uint64_t mSchedulerId;
+
+    inline LocMsgProducer(uint64_t schedulerId) :
+        mRefs(1), mLane(eMSG_Q_LANE_NORMAL), mLast(nullptr), mSchedulerId(schedulerId) {}
+
+    inline void unref() {
+        if (1 == mRefs.fetch_sub(1, std::memory_order_acq_rel)) {
+            delete this;
+        }
+    }
+
+    // called by the sending thread once it is done with it
+    inline void release() {
+        if (nullptr != mLast) {
+            LocMsgUnref(mLast);
+        }
+        unref();
+    }
+};
+
+// msg_q dealloc of a LocMsgEnvelope, also called once its msg was processed:
+// frees its msg, replacement included, and the envelope itself
+static void LocMsgDestroy(void* data) {
+    LocMsgEnvelope* env = (LocMsgEnvelope*)data;
+    LocMsgEnvelope* replacement = env->take();
+    if (nullptr != replacement) {
+        LocMsgFree(replacement);
+    }
+    LocMsgProducer* producer = env->mProducer;
+    LocMsgFree(env);
+    if (nullptr != producer) {
+        producer->unref();
+    }
 }
 
+static inline uint64_t LocMsgNowNs() {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Log-linear histogram of microsecond values, in the manner of HdrHistogram:
+// each power of 2 range is split into 4 buckets, i.e. 25% resolution from
+// 1us to over an hour in 128 buckets.
+class LocMsgHistogram {
+    static const uint32_t kSubBits = 2;
+    static const uint32_t kSubCount = 1 << kSubBits;
+    static const uint32_t kBucketCount = (32 - kSubBits + 1) * kSubCount;
+
+    uint32_t mBuckets[kBucketCount];
+    uint64_t mCount;
+    uint64_t mSum;
+    uint64_t mMax;
+
+    static inline uint32_t bucketOf(uint64_t value) {
+        if (value < kSubCount) {
+            return (uint32_t)value;
+        }
+        uint32_t msb = 63 - __builtin_clzll(value);
+        uint32_t bucket = (msb - kSubBits + 1) * kSubCount +
+                ((value >> (msb - kSubBits)) & (kSubCount - 1));
+        return std::min(bucket, kBucketCount - 1);
+    }
+
+    // the highest value that lands in bucket
+    static inline uint64_t bucketTop(uint32_t bucket) {
+        if (bucket < kSubCount) {
+            return bucket;
+        }
+        uint32_t msb = bucket / kSubCount + kSubBits - 1;
+        uint64_t sub = kSubCount + bucket % kSubCount;
+        return ((sub + 1) << (msb - kSubBits)) - 1;
+    }
+
+public:
+    inline LocMsgHistogram() : mBuckets(), mCount(0), mSum(0), mMax(0) {}
+
+    inline void add(uint64_t us) {
+        mBuckets[bucketOf(us)]++;
+        mCount++;
+        mSum += us;
+        mMax = std::max(mMax, us);
+    }
+
+    inline uint64_t getCount() const { return mCount; }
+    inline uint64_t getMean() const { return mCount ? mSum / mCount : 0; }
+    inline uint64_t getMax() const { return mMax; }
+
+    // upper bound of the value below which percent of the values are
+    uint64_t getPercentile(uint32_t percent) const {
+        uint64_t rank = (mCount * percent + 99) / 100;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < kBucketCount; i++) {
+            seen += mBuckets[i];
+            if (seen >= rank && seen > 0) {
+                return std::min(bucketTop(i), mMax);
+            }
+        }
+        return mMax;
+    }
+
+    void print(const char* what, std::string& out) const {
+        char line[160];
+        snprintf(line, sizeof(line), " %s p50/p90/p99/max %" PRIu64 "/%" PRIu64 "/%" PRIu64
+                 "/%" PRIu64 "us mean %" PRIu64 "us", what, getPercentile(50),
+                 getPercentile(90), getPercentile(99), mMax, getMean());
+        out += line;
+    }
+};
+
+// The build has no RTTI, so msgs are told apart by their vtable, which under
+// the Itanium C++ ABI is what the first word of a polymorphic object points
+// to. It is only turned into a name, through the dynamic symbol table, when
+// dumping.
+static inline const void* LocMsgTypeOf(const LocMsg* msg) {
+    return *reinterpret_cast<const void* const*>(msg);
+}
+
+static std::string LocMsgTypeName(const void* type) {
+    std::string name;
+    Dl_info info = {};
+    if (0 != dladdr(type, &info) && nullptr != info.dli_sname) {
+        int status = -1;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = (0 == status && nullptr != demangled) ? demangled : info.dli_sname;
+        free(demangled);
+        // "vtable for X" -> "X"
+        const char* prefix = "vtable for ";
+        if (0 == name.compare(0, strlen(prefix), prefix)) {
+            name.erase(0, strlen(prefix));
+        }
+    } else {
+        char addr[32];
+        snprintf(addr, sizeof(addr), "LocMsg@%p", type);
+        name = addr;
+    }
+    return name;
+}
+
+class LocMsgStats {
+    struct TypeStats {
+        LocMsgHistogram mWait;
+        LocMsgHistogram mProc;
+    };
+    std::atomic<bool> mEnabled;
+    std::mutex mLock;
+    std::unordered_map<const void*, TypeStats> mTypes;
+public:
+    inline LocMsgStats() : mEnabled(false) {}
+
+    inline bool isEnabled() const { return mEnabled.load(std::memory_order_relaxed); }
+    inline void enable(bool enable) { mEnabled = enable; }
+
+    inline uint64_t queuedAt() const {
+        return isEnabled() ? LocMsgNowNs() : 0;
+    }
+
+    // msg->log() and proc(), timed if it was queued with stats on
+    void run(const LocMsg* msg, uint64_t queuedAtNs) {
+        if (0 == queuedAtNs || !isEnabled()) {
+            msg->log();
+            // there is where each individual msg handling is invoked
+            msg->proc();
+            return;
+        }
+
+        const void* type = LocMsgTypeOf(msg);
+        uint64_t startNs = LocMsgNowNs();
+        msg->log();
+        msg->proc();
+        uint64_t endNs = LocMsgNowNs();
+
+        std::lock_guard<std::mutex> lock(mLock);
+        TypeStats& stats = mTypes[type];
+        stats.mWait.add((startNs - queuedAtNs) / 1000);
+        stats.mProc.add((endNs - startNs) / 1000);
+    }
+
+    void dump(std::string& out) {
+        std::vector<std::pair<std::string, TypeStats>> types;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            types.reserve(mTypes.size());
+            for (auto& type : mTypes) {
+                types.emplace_back(LocMsgTypeName(type.first), type.second);
+            }
+        }
+        std::sort(types.begin(), types.end(),
+                  [](const std::pair<std::string, TypeStats>& a,
+                     const std::pair<std::string, TypeStats>& b) {
+                      return a.second.mWait.getCount() > b.second.mWait.getCount();
+                  });
+        for (auto& type : types) {
+            char count[32];
+            snprintf(count, sizeof(count), " n %" PRIu64, type.second.mWait.getCount());
+            out += type.first;
+            out += count;
+            type.second.mWait.print("wait", out);
+            type.second.mProc.print("proc", out);
+            out += "\n";
+        }
+    }
+};
+
+// The LocMsgProducer of this thread for each of the last MsgTasks it sent to
+class LocMsgProducers {
+    static const uint32_t kMaxProducers = 16;
+    LocMsgProducer* mProducers[kMaxProducers];
+    uint32_t mNext;
+public:
+    inline LocMsgProducers() : mProducers(), mNext(0) {}
+    inline ~LocMsgProducers() {
+        for (uint32_t i = 0; i < kMaxProducers; i++) {
+            if (nullptr != mProducers[i]) {
+                mProducers[i]->release();
+            }
+        }
+    }
+
+    LocMsgProducer& get(uint64_t schedulerId) {
+        for (uint32_t i = 0; i < kMaxProducers; i++) {
+            if (nullptr != mProducers[i] && schedulerId == mProducers[i]->mSchedulerId) {
+                return *mProducers[i];
+            }
+        }
+        // a free slot, else one with nothing queued, else the oldest one;
+        // only then may this thread's msgs to that MsgTask be reordered
+        uint32_t slot = mNext;
+        for (uint32_t i = 0; i < kMaxProducers; i++) {
+            if (nullptr == mProducers[i]) {
+                slot = i;
+                break;
+            }
+            if (1 == mProducers[i]->mRefs.load(std::memory_order_acquire)) {
+                slot = i;
+            }
+        }
+        if (slot == mNext) {
+            mNext = (mNext + 1) % kMaxProducers;
+        }
+        if (nullptr != mProducers[slot]) {
+            mProducers[slot]->release();
+        }
+        mProducers[slot] = new LocMsgProducer(schedulerId);
+        return *mProducers[slot];
+    }
+};
+static thread_local LocMsgProducers sProducers;
+
+// Decides the lane each envelope is queued in, keeping the msgs of a sending
+// thread in the order it sent them: while some of them are still queued, the
+// next ones go to the same lane, whatever their priority. Also has a newer
+// msg with the same coalescing key as the envelope a sending thread queued
+// last replace it, instead of being queued itself; any other msg queued in
+// between would otherwise be overtaken. All of it is kept per sending thread,
+// so that sending takes no lock.
+class LocMsgScheduler {
+    static std::atomic<uint64_t> sNextId;
+    // tells this scheduler's producers apart from those of one freed before
+    const uint64_t mId;
+    std::atomic<uint64_t> mCoalesced;
+public:
+    inline LocMsgScheduler() : mId(sNextId++), mCoalesced(0) {}
+
+    // Called from the sending thread. Stores in queued, with its lane in
+    // lanes, each of envs that is to be queued, and returns how many. Any
+    // other one replaces the envelope queued before it.
+    uint32_t schedule(LocMsgEnvelope* const* envs, uint32_t count,
+                      void** queued, msg_q_lane_type* lanes) {
+        LocMsgProducer& producer = sProducers.get(mId);
+        uint32_t queuedCount = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            LocMsgEnvelope* env = envs[i];
+            LocMsgEnvelope* last = producer.mLast;
+            if (0 != env->mCoalesceKey && nullptr != last &&
+                    last->mCoalesceKey == env->mCoalesceKey) {
+                // fails only once the MsgTask thread has taken last
+                LocMsgEnvelope* replaced = last->mReplacement.load(std::memory_order_acquire);
+                if (LocMsgEnvelope::taken() != replaced &&
+                        last->mReplacement.compare_exchange_strong(
+                                replaced, env, std::memory_order_acq_rel)) {
+                    // never seen by the MsgTask thread
+                    if (nullptr != replaced) {
+                        LocMsgFree(replaced);
+                    }
+                    mCoalesced.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+            }
+
+            if (1 == producer.mRefs.fetch_add(1, std::memory_order_acq_rel)) {
+                producer.mLane = (msg_q_lane_type)env->mPriority;
+            }
+            env->mProducer = &producer;
+            if (nullptr != last) {
+                producer.mLast = nullptr;
+                LocMsgUnref(last);
+            }
+            if (0 != env->mCoalesceKey) {
+                // not queued yet, no other thread has it
+                env->mRefs.store(2, std::memory_order_relaxed);
+                producer.mLast = env;
+            }
+            queued[queuedCount] = env;
+            lanes[queuedCount] = producer.mLane;
+            queuedCount++;
+        }
+        return queuedCount;
+    }
+
+    inline uint64_t getCoalescedCount() const { return mCoalesced.load(); }
+};
+
+std::atomic<uint64_t> LocMsgScheduler::sNextId(1);
+
+// Hashed timing wheel of the msgs sent with sendMsgDelayed() / sendMsgAt().
+// Each slot holds the timers of one kTickMs tick, modulo a turn of the wheel,
+// so adding a timer, and finding and taking out a due one, only ever looks
+// at a slot or a turn of slots, whatever the number of timers pending. The
+// MsgTask thread drives it from the timeout of its msg_q receive.
+class LocMsgTimerWheel {
+    static const uint32_t kTickMs = 4;
+    static const uint32_t kSlotCount = 256;
+
+    struct Timer {
+        uint64_t mId;
+        uint64_t mDeadlineMs;
+        uint64_t mTick;
+        LocMsg* mMsg;
+        Timer* mNext;
+    };
+
+    std::mutex mLock;
+    Timer* mSlots[kSlotCount];
+    std::unordered_map<uint64_t, Timer*> mTimers;
+    uint64_t mNextId;
+    // no timer is due before this tick
+    uint64_t mCurrentTick;
+    // when the MsgTask thread is to wake up next on its own
+    uint64_t mWakeUpMs;
+    pthread_t mOwner;
+    bool mHasOwner;
+
+    void unlink(Timer* timer) {
+        Timer** link = &mSlots[timer->mTick % kSlotCount];
+        while (*link != timer) {
+            link = &(*link)->mNext;
+        }
+        *link = timer->mNext;
+        mTimers.erase(timer->mId);
+    }
+
+public:
+    inline LocMsgTimerWheel() :
+        mSlots(), mNextId(1), mCurrentTick(LocMsgNowNs() / 1000000 / kTickMs),
+        mWakeUpMs(UINT64_MAX), mOwner(), mHasOwner(false) {}
+    inline ~LocMsgTimerWheel() {
+        for (auto& timer : mTimers) {
+            delete timer.second->mMsg;
+            delete timer.second;
+        }
+    }
+
+    // called on the MsgTask thread
+    inline void setOwner() {
+        std::lock_guard<std::mutex> lock(mLock);
+        mOwner = pthread_self();
+        mHasOwner = true;
+    }
+
+    // wakeUp is set if the MsgTask thread must be woken up for the timer
+    uint64_t add(LocMsg* msg, uint64_t deadlineMs, bool& wakeUp) {
+        Timer* timer = new Timer();
+        std::lock_guard<std::mutex> lock(mLock);
+        timer->mId = mNextId++;
+        timer->mDeadlineMs = deadlineMs;
+        timer->mTick = std::max(deadlineMs / kTickMs, mCurrentTick);
+        timer->mMsg = msg;
+        timer->mNext = mSlots[timer->mTick % kSlotCount];
+        mSlots[timer->mTick % kSlotCount] = timer;
+        mTimers[timer->mId] = timer;
+
+        // the MsgTask thread looks again before it waits next
+        wakeUp = deadlineMs < mWakeUpMs && !(mHasOwner && pthread_equal(mOwner, pthread_self()));
+        if (wakeUp) {
+            mWakeUpMs = deadlineMs;
+        }
+        return timer->mId;
+    }
+
+    bool cancel(uint64_t id) {
+        LocMsg* msg = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            auto it = mTimers.find(id);
+            if (it == mTimers.end()) {
+                return false;
+            }
+            Timer* timer = it->second;
+            unlink(timer);
+            msg = timer->mMsg;
+            delete timer;
+        }
+        delete msg;
+        return true;
+    }
+
+    // Takes out the msg of one due timer, nullptr if none is. One at a time,
+    // as processing a msg may cancel the next one.
+    LocMsg* takeExpired(uint64_t nowMs) {
+        std::lock_guard<std::mutex> lock(mLock);
+        uint64_t nowTick = nowMs / kTickMs;
+        if (mTimers.empty()) {
+            mCurrentTick = std::max(mCurrentTick, nowTick);
+            return nullptr;
+        }
+        // a full turn at most, which looks at every slot
+        uint64_t lastTick = std::min(nowTick, mCurrentTick + kSlotCount - 1);
+        for (uint64_t tick = mCurrentTick; tick <= lastTick; tick++) {
+            Timer* due = nullptr;
+            for (Timer* timer = mSlots[tick % kSlotCount]; nullptr != timer;
+                 timer = timer->mNext) {
+                if (timer->mDeadlineMs <= nowMs && (nullptr == due ||
+                        timer->mDeadlineMs < due->mDeadlineMs ||
+                        (timer->mDeadlineMs == due->mDeadlineMs && timer->mId < due->mId))) {
+                    due = timer;
+                }
+            }
+            if (nullptr != due) {
+                unlink(due);
+                LocMsg* msg = due->mMsg;
+                delete due;
+                return msg;
+            }
+            if (tick < nowTick) {
+                mCurrentTick = tick + 1;
+            }
+        }
+        mCurrentTick = std::max(mCurrentTick, nowTick);
+        return nullptr;
+    }
+
+    // How long the MsgTask thread may wait for msgs before the next timer is
+    // due, in ms; -1 if there is no timer.
+    int32_t getTimeout(uint64_t nowMs) {
+        std::lock_guard<std::mutex> lock(mLock);
+        uint64_t deadlineMs = UINT64_MAX;
+        if (!mTimers.empty()) {
+            for (uint64_t tick = mCurrentTick;
+                 tick < mCurrentTick + kSlotCount && UINT64_MAX == deadlineMs; tick++) {
+                for (Timer* timer = mSlots[tick % kSlotCount]; nullptr != timer;
+                     timer = timer->mNext) {
+                    if (timer->mTick == tick) {
+                        deadlineMs = std::min(deadlineMs, timer->mDeadlineMs);
+                    }
+                }
+            }
+            // nothing due within a turn
+            if (UINT64_MAX == deadlineMs) {
+                for (auto& timer : mTimers) {
+                    deadlineMs = std::min(deadlineMs, timer.second->mDeadlineMs);
+                }
+            }
+        }
+        mWakeUpMs = deadlineMs;
+        if (UINT64_MAX == deadlineMs) {
+            return -1;
+        }
+        return (int32_t)std::min<uint64_t>(deadlineMs > nowMs ? deadlineMs - nowMs : 0,
+                                           INT32_MAX);
+    }
+};
+
+struct LocMsgTaskState {
+    LocMsgPool* const mPool;
+    LocMsgScheduler mScheduler;
+    LocMsgStats mStats;
+    LocMsgTimerWheel mTimers;
+
+    inline LocMsgTaskState() : mPool(new LocMsgPool()) {}
+    // msgs still queued hold their own references on the pool
+    inline ~LocMsgTaskState() { mPool->release(); }
+};
+
+// queued to have the MsgTask thread look at its timers again
+struct TimerWakeUpMsg : public LocMsg {
+    inline virtual void proc() const override {}
+};
+
+// msgs held back by the BatchScope's of this thread; the vectors keep their
+// capacity from one scope to the next
+struct LocMsgBatch {
+    uint32_t mDepth = 0;
+    std::vector<std::pair<const MsgTask*, LocMsgEnvelope*>> mMsgs;
+    std::vector<LocMsgEnvelope*> mTaskMsgs;
+};
+static thread_local LocMsgBatch sBatch;
+
+// up to this many msgs are queued at once without allocating
+static const uint32_t kInlineMsgCount = 16;
+
 MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+    MsgTask(threadName, 0, 1) {}
+
+MsgTask::MsgTask(const char* threadName, uint32_t ringCapacity, uint32_t drainBatchSize) :
+    mQ(0 == ringCapacity ? msg_q_init2() : msg_q_init_ring2(ringCapacity)),
+    mThread(), mState(new LocMsgTaskState()) {
+    mThread.start(threadName, std::make_shared<MTRunnable>(mQ, mState, drainBatchSize));
+}
+
+LocMsgPoolStats MsgTask::getMsgPoolStats() const {
+    return mState->mPool->getStats();
+}
+
+uint64_t MsgTask::getCoalescedCount() const {
+    return mState->mScheduler.getCoalescedCount();
+}
+
+void MsgTask::enableStats(bool enable) const {
+    mState->mStats.enable(enable);
+}
+
+bool MsgTask::isStatsEnabled() const {
+    return mState->mStats.isEnabled();
+}
+
+void MsgTask::dumpStats(std::string& out) const {
+    static const char* laneNames[LOC_MSG_PRIORITY_COUNT] = { "high", "normal", "background" };
+    char line[128];
+    for (int lane = 0; lane < LOC_MSG_PRIORITY_COUNT; lane++) {
+        LocMsgLaneStats stats = getLaneStats((LocMsgPriority)lane);
+        snprintf(line, sizeof(line), "lane %s depth %u max %u\n",
+                 laneNames[lane], stats.depth, stats.maxDepth);
+        out += line;
+    }
+    LocMsgPoolStats poolStats = getMsgPoolStats();
+    snprintf(line, sizeof(line), "pool hits %" PRIu64 " misses %" PRIu64
+             " coalesced %" PRIu64 "\n", poolStats.hits, poolStats.misses,
+             getCoalescedCount());
+    out += line;
+    mState->mStats.dump(out);
+}
+
+LocMsgLaneStats MsgTask::getLaneStats(LocMsgPriority priority) const {
+    LocMsgLaneStats stats = {};
+    msg_q_get_lane_depth((void*)mQ, (msg_q_lane_type)priority,
+                         &stats.depth, &stats.maxDepth);
+    return stats;
+}
+
+void* MsgTask::allocMsg(size_t size) const {
+    LocMsgEnvelope* env = mState->mPool->alloc(size);
+    env->mInline = true;
+    return env->storage();
+}
+
+void MsgTask::sendAllocated(void* storage, const LocMsg* msg, LocMsgPriority priority,
+                            uint64_t coalesceKey) const {
+    LocMsgEnvelope* env = LocMsgEnvelope::fromStorage(storage);
+    env->mMsg = msg;
+    env->mCoalesceKey = coalesceKey;
+    env->mPriority = priority;
+    post(env);
+}
+
+void MsgTask::post(LocMsgEnvelope* env) const {
+    if (sBatch.mDepth > 0) {
+        sBatch.mMsgs.emplace_back(this, env);
+    } else {
+        queue(&env, 1);
+    }
+}
+
+void MsgTask::queue(LocMsgEnvelope* const* envs, uint32_t count) const {
+    void* inlineQueued[kInlineMsgCount];
+    msg_q_lane_type inlineLanes[kInlineMsgCount];
+    std::vector<void*> queuedVector;
+    std::vector<msg_q_lane_type> lanesVector;
+    void** queued = inlineQueued;
+    msg_q_lane_type* lanes = inlineLanes;
+    if (count > kInlineMsgCount) {
+        queuedVector.resize(count);
+        lanesVector.resize(count);
+        queued = queuedVector.data();
+        lanes = lanesVector.data();
+    }
+
+    uint64_t queuedAtNs = mState->mStats.queuedAt();
+    for (uint32_t i = 0; i < count; i++) {
+        envs[i]->mQueuedAtNs = queuedAtNs;
+    }
+    // once scheduled, an envelope may be run and freed by the MsgTask thread
+    uint32_t queuedCount = mState->mScheduler.schedule(envs, count, queued, lanes);
+    if (0 == queuedCount) {
+        return;
+    }
+
+    msq_q_err_type result = (1 == queuedCount) ?
+            msg_q_snd_lane((void*)mQ, queued[0], LocMsgDestroy, lanes[0]) :
+            msg_q_snd_batch((void*)mQ, queued, lanes, queuedCount, LocMsgDestroy);
+    if (eMSG_Q_SUCCESS != result) {
+        LOC_LOGE("%s: fail sending %u msgs: %s", __func__, queuedCount,
+                 loc_get_msg_q_status(result));
+        // the queue is shutting down and took none of them
+        if (eMSG_Q_UNAVAILABLE_RESOURCE == result) {
+            for (uint32_t i = 0; i < queuedCount; i++) {
+                LocMsgDestroy(queued[i]);
+            }
+        }
+    }
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
+    sendMsg(msg, LOC_MSG_PRIORITY_NORMAL);
+}
+
+void MsgTask::sendMsg(const LocMsg* msg, LocMsgPriority priority, uint64_t coalesceKey) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        LocMsgEnvelope* env = mState->mPool->alloc(0);
+        env->mMsg = msg;
+        env->mCoalesceKey = coalesceKey;
+        env->mPriority = priority;
+        post(env);
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
     }
 }
 
+void MsgTask::sendMsgs(const LocMsg* const* msgs, uint32_t count) const {
+    if (nullptr == msgs || nullptr == this) {
+        LOC_LOGE("%s: msgs is %p and this is %p", __func__, msgs, this);
+        return;
+    }
+    LocMsgEnvelope* inlineEnvs[kInlineMsgCount];
+    std::vector<LocMsgEnvelope*> envsVector;
+    LocMsgEnvelope** envs = inlineEnvs;
+    if (count > kInlineMsgCount) {
+        envsVector.resize(count);
+        envs = envsVector.data();
+    }
+    uint32_t envCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (nullptr != msgs[i]) {
+            LocMsgEnvelope* env = mState->mPool->alloc(0);
+            env->mMsg = msgs[i];
+            envs[envCount++] = env;
+        }
+    }
+    if (envCount > 0) {
+        queue(envs, envCount);
+    }
+}
+
+uint64_t MsgTask::sendMsgDelayed(const LocMsg* msg, uint32_t delayMs) const {
+    return sendMsgAt(msg, LocMsgNowNs() / 1000000 + delayMs);
+}
+
+uint64_t MsgTask::sendMsgAt(const LocMsg* msg, uint64_t monotonicTimeMs) const {
+    if (nullptr == msg || nullptr == this) {
+        LOC_LOGE("%s: msg is %p and this is %p", __func__, msg, this);
+        return 0;
+    }
+    bool wakeUp = false;
+    uint64_t id = mState->mTimers.add((LocMsg*)msg, monotonicTimeMs, wakeUp);
+    if (wakeUp) {
+        // not the sender's, so it may overtake whatever is queued
+        LocMsgEnvelope* env = LocMsgEnvelope::fromStorage(allocMsg(sizeof(TimerWakeUpMsg)));
+        env->mMsg = new (env->storage()) TimerWakeUpMsg();
+        if (eMSG_Q_SUCCESS != msg_q_snd_lane((void*)mQ, env, LocMsgDestroy,
+                                             eMSG_Q_LANE_HIGH)) {
+            LocMsgDestroy(env);
+        }
+    }
+    return id;
+}
+
+bool MsgTask::cancelMsg(uint64_t id) const {
+    return mState->mTimers.cancel(id);
+}
+
+MsgTask::BatchScope::BatchScope() {
+    sBatch.mDepth++;
+}
+
+MsgTask::BatchScope::~BatchScope() {
+    if (--sBatch.mDepth > 0 || sBatch.mMsgs.empty()) {
+        return;
+    }
+    // the depth being 0, no send made meanwhile adds to either vector
+    std::vector<std::pair<const MsgTask*, LocMsgEnvelope*>>& pending = sBatch.mMsgs;
+    std::vector<LocMsgEnvelope*>& msgs = sBatch.mTaskMsgs;
+    // one queue() per MsgTask, in the order each was first sent to
+    for (size_t i = 0; i < pending.size(); i++) {
+        const MsgTask* task = pending[i].first;
+        if (nullptr == task) {
+            continue;
+        }
+        msgs.clear();
+        for (size_t j = i; j < pending.size(); j++) {
+            if (pending[j].first == task) {
+                msgs.push_back(pending[j].second);
+                pending[j].first = nullptr;
+            }
+        }
+        task->queue(msgs.data(), msgs.size());
+    }
+    pending.clear();
+}
+
 void MsgTask::sendMsg(const std::function<void()> runnable) const {
     struct RunMsg : public LocMsg {
         const std::function<void()> mRunnable;
@@ -82,7 +967,7 @@ void MsgTask::sendMsg(const std::function<void()> runnable) const {
         ~RunMsg() = default;
         inline virtual void proc() const override { mRunnable(); }
     };
-    sendMsg(new RunMsg(runnable));
+    emplaceMsg<RunMsg>(LOC_MSG_PRIORITY_NORMAL, 0, runnable);
 }
 
 void MTRunnable::interrupt() {
@@ -92,22 +977,62 @@ void MTRunnable::interrupt() {
 void MTRunnable::prerun() {
     // make sure we do not run in background scheduling group
      set_sched_policy(gettid(), SP_FOREGROUND);
+     mState->mTimers.setOwner();
+}
+
+void MTRunnable::run(LocMsgEnvelope* env) {
+    LocMsgEnvelope* replacement = env->take();
+    LocMsgEnvelope* running = (nullptr != replacement) ? replacement : env;
+    mState->mStats.run(running->mMsg, running->mQueuedAtNs);
+    if (nullptr != replacement) {
+        LocMsgFree(replacement);
+    }
+    LocMsgDestroy(env);
 }
 
 bool MTRunnable::run() {
+    // due delayed msgs go first
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
+    while (nullptr != (msg = mState->mTimers.takeExpired(LocMsgNowNs() / 1000000))) {
+        mState->mStats.run(msg, mState->mStats.queuedAt());
+        delete msg;
+    }
+    int32_t timeoutMs = mState->mTimers.getTimeout(LocMsgNowNs() / 1000000);
+
+    if (!mBatch.empty()) {
+        uint32_t count = 0;
+        msq_q_err_type result = (timeoutMs < 0) ?
+                msg_q_rcv_batch((void*)mQ, mBatch.data(), mBatch.size(), &count) :
+                msg_q_rcv_batch_timed((void*)mQ, mBatch.data(), mBatch.size(), &count,
+                                      timeoutMs);
+        if (eMSG_Q_TIMEOUT == result) {
+            return true;
+        }
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msgs: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            return false;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            run((LocMsgEnvelope*)mBatch[i]);
+        }
+        return true;
+    }
+
+    void* env = nullptr;
+    msq_q_err_type result = (timeoutMs < 0) ?
+            msg_q_rcv((void*)mQ, &env) :
+            msg_q_rcv_timed((void*)mQ, &env, timeoutMs);
+    if (eMSG_Q_TIMEOUT == result) {
+        return true;
+    }
     if (eMSG_Q_SUCCESS != result) {
         LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
                  loc_get_msg_q_status(result));
         return false;
     }
 
-    msg->log();
-    // there is where each individual msg handling is invoked
-    msg->proc();
-
-    delete msg;
+    run((LocMsgEnvelope*)env);
 
     return true;
 }
@@ -115,6 +1040,7 @@ bool MTRunnable::run() {
 MTRunnable::~MTRunnable() {
     msg_q_flush((void*)mQ);
     msg_q_destroy((void**)&mQ);
+    delete mState;
 }
 
 } // namespace loc_util
@@ -29,11 +29,50 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
+#include <cstddef>
+#include <new>
+#include <utility>
 #include <functional>
+#include <string>
 #include <LocThread.h>
 
 namespace loc_util {
 
+// What MsgTask queues for each LocMsg, and keeps about it
+struct LocMsgEnvelope;
+// What a MsgTask keeps besides its msg_q and thread: its envelope pool,
+// scheduler, stats and timers
+struct LocMsgTaskState;
+
+// Builds a coalescing key for MsgTask::sendMsg out of an object owned by the
+// sender, e.g. the adapter, and a tag of 0 to 15 telling that sender's
+// streams apart.
+#define LOC_MSG_COALESCE_KEY(owner, tag) \
+    ((((uint64_t)(uintptr_t)(owner)) << 4) | ((uint64_t)(tag) & 0xF))
+
+// Scheduling class of a LocMsg, given to MsgTask::sendMsg. MsgTask serves the
+// classes in this order, with starvation protection, each one being FIFO on
+// its own. The msgs of one sending thread are never reordered though: while
+// a thread still has msgs queued, its next ones queue behind them in the same
+// class, so priority only ever puts one thread's msgs ahead of another's.
+enum LocMsgPriority {
+    LOC_MSG_PRIORITY_HIGH = 0,      // position, SV, measurement delivery
+    LOC_MSG_PRIORITY_NORMAL,        // commands and everything else
+    LOC_MSG_PRIORITY_BACKGROUND,    // bulk notifications that can wait
+    LOC_MSG_PRIORITY_COUNT
+};
+
+struct LocMsgLaneStats {
+    uint32_t depth;     // messages currently queued
+    uint32_t maxDepth;  // high water mark of depth
+};
+
+struct LocMsgPoolStats {
+    uint64_t hits;      // allocations served from a recycled block
+    uint64_t misses;    // allocations that had to go to the heap
+};
+
 struct LocMsg {
     inline LocMsg() {}
     inline virtual ~LocMsg() {}
@@ -44,11 +83,88 @@ struct LocMsg {
 class MsgTask {
     const void* mQ;
     LocThread mThread;
+    // owned by the runnable of mThread, which outlives the MsgTask
+    LocMsgTaskState* mState;
+
+    // storage for a msg of size bytes, in a new envelope from mPool
+    void* allocMsg(size_t size) const;
+    // sends msg, which was built in storage from allocMsg()
+    void sendAllocated(void* storage, const LocMsg* msg, LocMsgPriority priority,
+                       uint64_t coalesceKey) const;
+    // queues envs now, or when the BatchScope of this thread ends
+    void post(LocMsgEnvelope* env) const;
+    void queue(LocMsgEnvelope* const* envs, uint32_t count) const;
 public:
     ~MsgTask() = default;
     MsgTask(const char* threadName = NULL);
+    // ringCapacity of 0 uses the mutex protected linked list msg_q; any
+    // other value selects the lock free ring msg_q with that many slots.
+    // drainBatchSize is the max number of msgs the MsgTask thread takes out
+    // of the queue at once.
+    MsgTask(const char* threadName, uint32_t ringCapacity, uint32_t drainBatchSize);
     void sendMsg(const LocMsg* msg) const;
+    // Sends msg with the given priority. A non 0 coalesceKey marks a msg of
+    // which only the newest matters: while the last msg this thread queued
+    // has the same key and is still queued, msg replaces it in place instead
+    // of queuing behind it. Any other msg this thread queued since keeps it
+    // from doing so, so that msg is never overtaken.
+    void sendMsg(const LocMsg* msg, LocMsgPriority priority, uint64_t coalesceKey = 0) const;
     void sendMsg(const std::function<void()> runnable) const;
+    // Sends msgs[0] to msgs[count - 1], in that order, waking up the MsgTask
+    // thread only once.
+    void sendMsgs(const LocMsg* const* msgs, uint32_t count) const;
+
+    // Has msg processed delayMs from now. The MsgTask thread keeps it and
+    // runs it itself once due, ahead of the queued msgs, so no other thread
+    // or timer is involved. Time is CLOCK_MONOTONIC, i.e. it does not count
+    // while suspended, nor does it wake the device up; use LocTimer for that.
+    // Returns the id to cancel it with, never 0.
+    uint64_t sendMsgDelayed(const LocMsg* msg, uint32_t delayMs) const;
+    // same, at the given CLOCK_MONOTONIC time in ms
+    uint64_t sendMsgAt(const LocMsg* msg, uint64_t monotonicTimeMs) const;
+    // Deletes a msg sent with sendMsgDelayed() or sendMsgAt() before it is
+    // processed. Returns false if it has already been processed.
+    bool cancelMsg(uint64_t id) const;
+
+    // While a BatchScope is alive, sendMsg() calls made from its thread, to
+    // any MsgTask, are held back and handed over with one sendMsgs() per
+    // MsgTask when the outermost scope ends. Meant for fan outs that send
+    // one msg to each of several adapters; nothing in the scope may wait
+    // for one of those msgs to be processed.
+    class BatchScope {
+    public:
+        BatchScope();
+        ~BatchScope();
+        BatchScope(const BatchScope&) = delete;
+        BatchScope& operator=(const BatchScope&) = delete;
+    };
+
+    // Constructs a T in storage recycled from this MsgTask's pool and sends
+    // it as sendMsg() does. Meant for the high rate report messages, whose
+    // storage is given back right after proc() on this same thread and reused
+    // by the next one. The T is MsgTask's own; it is never deleted as such.
+    template <typename T, typename... Args>
+    inline void emplaceMsg(LocMsgPriority priority, uint64_t coalesceKey,
+                           Args&&... args) const {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "T is overaligned");
+        void* storage = allocMsg(sizeof(T));
+        sendAllocated(storage, new (storage) T(std::forward<Args>(args)...),
+                      priority, coalesceKey);
+    }
+    LocMsgPoolStats getMsgPoolStats() const;
+    LocMsgLaneStats getLaneStats(LocMsgPriority priority) const;
+    // number of messages dropped because a newer one with the same
+    // coalescing key replaced them before they were processed
+    uint64_t getCoalescedCount() const;
+
+    // Turns on / off timing of every msg, recording per msg type how long
+    // it waited in the queue and how long its proc() took. Off by default.
+    void enableStats(bool enable) const;
+    bool isStatsEnabled() const;
+    // Appends to out one line per lane with its depth, and one line per msg
+    // type with its wait and proc() time percentiles. A msg that replaced
+    // another one under a coalescing key is counted from when it was sent.
+    void dumpStats(std::string& out) const;
 };
 
 } //
@@ -106,7 +106,9 @@ DECLARE_TBL(loc_msg_q_status) =
     NAME_VAL( eMSG_Q_INVALID_PARAMETER ),
     NAME_VAL( eMSG_Q_INVALID_HANDLE ),
     NAME_VAL( eMSG_Q_UNAVAILABLE_RESOURCE ),
-    NAME_VAL( eMSG_Q_INSUFFICIENT_BUFFER )
+    NAME_VAL( eMSG_Q_INSUFFICIENT_BUFFER ),
+    NAME_VAL( eMSG_Q_EMPTY ),
+    NAME_VAL( eMSG_Q_TIMEOUT )
 };
 
 /* Find msg_q status name */
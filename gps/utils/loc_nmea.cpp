@@ -152,6 +152,141 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+/*===========================================================================
+CLASS       LocNmeaFormatter
+
+DESCRIPTION
+   Formats sentence fields without going through snprintf. The output, the
+   truncation at the end of the buffer and length() are all the same as
+   snprintf(out, size, ...) with the matching format would give.
+
+   fixed() turns the value into an integer count of 10^-precision units and
+   prints its digits. It falls back to snprintf when the value is not
+   finite, too large, or so close to a rounding tie that the scaled double
+   may round differently than printf's exact decimal conversion.
+
+===========================================================================*/
+class LocNmeaFormatter {
+public:
+    inline LocNmeaFormatter(char* out, int size) :
+        mOut(out), mSize(size), mLength(0) {}
+
+    // %s
+    inline LocNmeaFormatter& str(const char* s) {
+        while ('\0' != *s) {
+            chr(*s++);
+        }
+        return *this;
+    }
+    // %c
+    inline LocNmeaFormatter& chr(char c) {
+        if (mLength < mSize - 1) {
+            mOut[mLength] = c;
+        }
+        mLength++;
+        return *this;
+    }
+    // %0<width>d
+    inline LocNmeaFormatter& num(int value, int width) {
+        unsigned int n = (value < 0) ? (0u - (unsigned int)value) : (unsigned int)value;
+        char digits[16];
+        int count = 0;
+        do {
+            digits[count++] = '0' + n % 10;
+            n /= 10;
+        } while (0 != n);
+        return putDigits(value < 0, digits, count, 0, width);
+    }
+    // %02X
+    inline LocNmeaFormatter& hex(uint8_t value) {
+        static const char hexDigits[] = "0123456789ABCDEF";
+        return chr(hexDigits[value >> 4]).chr(hexDigits[value & 0xF]);
+    }
+    // %0<width>.<precision>lf
+    inline LocNmeaFormatter& fixed(double value, int precision, int width = 0) {
+        static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+        if (precision < 0 || precision >= (int)(sizeof(pow10) / sizeof(pow10[0]))) {
+            return fixedSlow(value, precision, width);
+        }
+        // below 2^32 the product is off by less than 2^-21 from the exact value
+        double scaled = fabs(value) * pow10[precision];
+        if (!(scaled < 4294967296.0)) {
+            return fixedSlow(value, precision, width);
+        }
+        double whole = floor(scaled);
+        double fraction = scaled - whole;
+        if (fabs(fraction - 0.5) < (1.0 / 65536)) {
+            return fixedSlow(value, precision, width);
+        }
+        uint64_t n = (uint64_t)whole + ((fraction > 0.5) ? 1 : 0);
+        char digits[24];
+        int count = 0;
+        do {
+            digits[count++] = '0' + n % 10;
+            n /= 10;
+        } while (0 != n || count <= precision);
+        return putDigits(signbit(value), digits, count, precision, width);
+    }
+
+    // what snprintf returns; also NUL terminates, as it does
+    inline int length() {
+        if (mSize > 0) {
+            mOut[(mLength < mSize) ? mLength : (mSize - 1)] = '\0';
+        }
+        return mLength;
+    }
+
+private:
+    char* const mOut;
+    const int mSize;
+    int mLength;
+
+    // digits are least significant first, the last precision of them after the point
+    inline LocNmeaFormatter& putDigits(bool negative, const char* digits, int count,
+                                       int precision, int width) {
+        int total = count + ((precision > 0) ? 1 : 0) + (negative ? 1 : 0);
+        if (negative) {
+            chr('-');
+        }
+        for (; total < width; total++) {
+            chr('0');
+        }
+        for (; count > 0; count--) {
+            if (count == precision) {
+                chr('.');
+            }
+            chr(digits[count - 1]);
+        }
+        return *this;
+    }
+
+    LocNmeaFormatter& fixedSlow(double value, int precision, int width) {
+        char buf[512];
+        snprintf(buf, sizeof(buf), "%0*.*f", width, precision, value);
+        return str(buf);
+    }
+};
+
+/* XOR of len bytes, a word at a time */
+static uint8_t loc_nmea_xor(const char* p, size_t len)
+{
+    uint64_t word = 0;
+    size_t i = 0;
+    for (; i + sizeof(word) <= len; i += sizeof(word)) {
+        uint64_t w;
+        memcpy(&w, p + i, sizeof(w));
+        word ^= w;
+    }
+    word ^= word >> 32;
+    word ^= word >> 16;
+    word ^= word >> 8;
+    uint8_t checksum = (uint8_t)word;
+    for (; i < len; i++) {
+        checksum ^= (uint8_t)p[i];
+    }
+    return checksum;
+}
+
 /*===========================================================================
 FUNCTION    convert_Lla_to_Ecef
 
@@ -576,18 +711,18 @@ static int loc_nmea_put_checksum(char *pNmea, int maxSize, bool isTagBlock)
         return 0;
 
     pNmea++; //skip the $ or / for Tag Block
-    while (*pNmea != '\0')
-    {
-        checksum ^= *pNmea++;
-        length++;
-    }
+    length = strlen(pNmea);
+    checksum = loc_nmea_xor(pNmea, length);
+    pNmea += length;
 
     if (isTagBlock) {
         // length now contains tag block sentence string length not including / sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\\", checksum);
+        checksumLength = LocNmeaFormatter(pNmea, (maxSize-length-1)).
+                chr('*').hex(checksum).chr('\\').length();
     } else {
         // length now contains nmea sentence string length not including $ sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\r\n", checksum);
+        checksumLength = LocNmeaFormatter(pNmea, (maxSize-length-1)).
+                chr('*').hex(checksum).str("\r\n").length();
     }
     // total length of nmea sentence is length of nmea sentence inc $ sign plus
     // length of checksum (+1 is to cover the $ character in the length).
@@ -619,7 +754,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr,
+                              LocNmeaBuffer &nmeaBuffer,
                               bool isTagBlockGroupingEnabled)
 {
     if (!sentence || bufSize <= 0 || !sv_meta_p)
@@ -706,7 +841,8 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         for (uint8_t i = 0; i < 12; i++, svNumber++)
         {
             if (svNumber <= svUsedCount)
-                length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[svNumber - 1]);
+                length = LocNmeaFormatter(pMarker, lengthRemaining).
+                        num(svUsedList[svNumber - 1], 2).chr(',').length();
             else
                 length = snprintf(pMarker, lengthRemaining, ",");
 
@@ -721,10 +857,10 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         // Add the position/horizontal/vertical DOP values
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                    locationExtended.pdop,
-                    locationExtended.hdop,
-                    locationExtended.vdop);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(locationExtended.pdop, 1).chr(',').
+                    fixed(locationExtended.hdop, 1).chr(',').
+                    fixed(locationExtended.vdop, 1).chr(',').length();
         }
         else
         {   // no dop
@@ -740,7 +876,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
 
         /* Sentence is ready, add checksum and broadcast */
         length = loc_nmea_put_checksum(sentence + lengthTagBlock, bufSize - lengthTagBlock, false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
         sentenceNumber++;
         if (!isTagBlockGroupingEnabled) {
             break;
@@ -776,7 +912,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmeaBuffer)
 {
     if (!sentence || bufSize <= 0)
     {
@@ -812,8 +948,10 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         pMarker = sentence;
         lengthRemaining = bufSize;
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
+        // "$%sGSV,%d,%d,%02d"
+        length = LocNmeaFormatter(pMarker, lengthRemaining).chr('$').str(talker).str("GSV,").
+                num(sentenceCount, 0).chr(',').num(sentenceNumber, 0).chr(',').
+                num(svCount, 2).length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -866,14 +1004,18 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
                 }
                 if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
                     GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId) {
-                    length = snprintf(pMarker, lengthRemaining, ",,%02d,%03d,",
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
+                    // ",,%02d,%03d,"
+                    length = LocNmeaFormatter(pMarker, lengthRemaining).str(",,").
+                        num((int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), 2).chr(',').
+                        num((int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth), 3).chr(',').
+                        length(); //float to int
                 } else {
-                    length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
+                    // ",%02d,%02d,%03d,"
+                    length = LocNmeaFormatter(pMarker, lengthRemaining).chr(',').
+                        num(svNotify.gnssSvs[svNumber - 1].svId - svIdOffset, 2).chr(',').
+                        num((int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), 2).chr(',').
+                        num((int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth), 3).chr(',').
+                        length(); //float to int
                 }
                 if (length < 0 || length >= lengthRemaining)
                 {
@@ -885,8 +1027,9 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
 
                 if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
                 {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
+                    length = LocNmeaFormatter(pMarker, lengthRemaining).
+                            num((int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz), 2).
+                            length(); //float to int
 
                     if (length < 0 || length >= lengthRemaining)
                     {
@@ -908,7 +1051,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         lengthRemaining -= length;
 
         length = loc_nmea_put_checksum(sentence, bufSize, false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
         sentenceNumber++;
 
     }  //while
@@ -999,9 +1142,12 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
+    // "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,"
+    length = LocNmeaFormatter(pMarker, lengthRemaining).
+            num((uint8_t)floor(lla_offset[0]), 2).fixed(latMins, 6, 9).chr(',').
+            chr(latHem).chr(',').
+            num((uint8_t)floor(lla_offset[1]), 3).fixed(longMins, 6, 9).chr(',').
+            chr(longHem).chr(',').fixed(lla_offset[2], 3).chr(',').length();
     if (length < 0 || length >= lengthRemaining) {
         LOC_LOGE("NMEA Error in string formatting");
         return;
@@ -1331,7 +1477,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
-                               std::vector<std::string> &nmeaArraystr,
+                               LocNmeaBuffer &nmeaBuffer,
                                int& indexOfGGA,
                                bool isTagBlockGroupingEnabled)
 {
@@ -1414,7 +1560,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GPS_L1CA, true), nmeaBuffer, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1428,7 +1574,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GLONASS_G1, true), nmeaBuffer, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1442,7 +1588,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_GALILEO_E1, true), nmeaBuffer, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1455,7 +1601,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaBuffer, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1469,7 +1615,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr, isTagBlockGroupingEnabled);
+                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaBuffer, isTagBlockGroupingEnabled);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1482,7 +1628,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if (svUsedCount == 0) {
             strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
             length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-            nmeaArraystr.push_back(sentence);
+            nmeaBuffer.append(sentence);
         }
 
         char ggaGpsQuality[3] = {'0', '\0', '\0'};
@@ -1511,7 +1657,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                     magTrack -= 360.0;
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).chr('$').str(talker).
+                    str("VTG,").fixed(location.gpsLocation.bearing, 1).str(",T,").
+                    fixed(magTrack, 1).str(",M,").length();
         }
         else
         {
@@ -1531,7 +1679,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
             float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).fixed(speedKnots, 1).
+                    str(",N,").fixed(speedKmPerHour, 1).str(",K,").length();
         }
         else
         {
@@ -1549,7 +1698,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
 
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         memset(&ecef_w84, 0, sizeof(ecef_w84));
         memset(&ecef_p90, 0, sizeof(ecef_p90));
@@ -1604,13 +1753,10 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 (0 != sv_cache_info.qzss_used_mask) ||
                 (0 != sv_cache_info.bds_used_mask));
 
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        }
+        // "$%sRMC,%02d%02d%02d.%02d,A," or ",V,"
+        length = LocNmeaFormatter(pMarker, lengthRemaining).chr('$').str(talker).str("RMC,").
+                num(utcHours, 2).num(utcMinutes, 2).num(utcSeconds, 2).chr('.').
+                num(utcMSeconds/10, 2).chr(',').chr(validFix ? 'A' : 'V').chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1652,9 +1798,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            // "%02d%09.6lf,%c,%03d%09.6lf,%c,"
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    num((uint8_t)floor(latitude), 2).fixed(latMinutes, 6, 9).chr(',').
+                    chr(latHemisphere).chr(',').
+                    num((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',').
+                    chr(lonHemisphere).chr(',').length();
         }
         else
         {
@@ -1672,7 +1821,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(speedKnots, 1).chr(',').length();
         }
         else
         {
@@ -1689,7 +1839,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(location.gpsLocation.bearing, 1).chr(',').length();
         }
         else
         {
@@ -1761,8 +1912,10 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker = sentence_GNS;
         lengthRemaining = sizeof(sentence_GNS);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        // "$%sGNS,%02d%02d%02d.%02d,"
+        length = LocNmeaFormatter(pMarker, lengthRemaining).chr('$').str(talker).str("GNS,").
+                num(utcHours, 2).num(utcMinutes, 2).num(utcSeconds, 2).chr('.').
+                num(utcMSeconds/10, 2).chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1804,9 +1957,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            // "%02d%09.6lf,%c,%03d%09.6lf,%c,"
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    num((uint8_t)floor(latitude), 2).fixed(latMinutes, 6, 9).chr(',').
+                    chr(latHemisphere).chr(',').
+                    num((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',').
+                    chr(lonHemisphere).chr(',').length();
         }
         else
         {
@@ -1827,8 +1983,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).num(svUsedCount, 2).
+                    chr(',').fixed(locationExtended.hdop, 1).chr(',').length();
         }
         else {   // no hdop
             length = snprintf(pMarker, lengthRemaining, "%02d,,",
@@ -1845,8 +2001,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(locationExtended.altitudeMeanSeaLevel, 1).chr(',').length();
         }
         else
         {
@@ -1864,8 +2020,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1).chr(',').
+                    length();
         }
         else
         {
@@ -1923,8 +2080,10 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker = sentence_GGA;
         lengthRemaining = sizeof(sentence_GGA);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        // "$%sGGA,%02d%02d%02d.%02d,"
+        length = LocNmeaFormatter(pMarker, lengthRemaining).chr('$').str(talker).str("GGA,").
+                num(utcHours, 2).num(utcMinutes, 2).num(utcSeconds, 2).chr('.').
+                num(utcMSeconds/10, 2).chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1966,9 +2125,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            // "%02d%09.6lf,%c,%03d%09.6lf,%c,"
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    num((uint8_t)floor(latitude), 2).fixed(latMinutes, 6, 9).chr(',').
+                    chr(latHemisphere).chr(',').
+                    num((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',').
+                    chr(lonHemisphere).chr(',').length();
         }
         else
         {
@@ -1988,8 +2150,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             svUsedCount = MAX_SATELLITES_IN_USE;
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).str(ggaGpsQuality).chr(',').
+                    num(svUsedCount, 2).chr(',').fixed(locationExtended.hdop, 1).chr(',').
+                    length();
         }
         else
         {   // no hdop
@@ -2007,8 +2170,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(locationExtended.altitudeMeanSeaLevel, 1).str(",M,").length();
         }
         else
         {
@@ -2026,8 +2189,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaFormatter(pMarker, lengthRemaining).
+                    fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1).
+                    str(",M,").length();
         }
         else
         {
@@ -2074,48 +2238,48 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA), false);
 
         // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
+        nmeaBuffer.append(sentence_DTM);
         // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
+        nmeaBuffer.append(sentence_RMC);
         if(LOC_GNSS_DATUM_PZ90 == datum_type) {
             // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+            nmeaBuffer.append(sentence_DTM);
         }
         // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
+        nmeaBuffer.append(sentence_GNS);
         if(LOC_GNSS_DATUM_PZ90 == datum_type) {
             // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+            nmeaBuffer.append(sentence_DTM);
         }
         // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-        indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
+        nmeaBuffer.append(sentence_GGA);
+        indexOfGGA = static_cast<int>(nmeaBuffer.count() - 1);
     }
     //Send blank NMEA reports for non-final fixes
     else {
         strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
 
         strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
-        nmeaArraystr.push_back(sentence);
+        nmeaBuffer.append(sentence);
     }
 
     EXIT_LOG(%d, 0);
@@ -2140,7 +2304,7 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaBuffer &nmeaBuffer)
 {
     ENTRY_LOG();
 
@@ -2231,7 +2395,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L1CA, false), nmeaBuffer);
 
     // ---------------------
     // ------$GPGSV:L5------
@@ -2239,14 +2403,14 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L5, false), nmeaBuffer);
 
     // ---------------------
     // ------$GPGSV:L2------
     // ---------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L2, false), nmeaBuffer);
 
     // ---------------------
     // ------$GLGSV:G1------
@@ -2254,7 +2418,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G1, false), nmeaBuffer);
 
     // ---------------------
     // ------$GLGSV:G2------
@@ -2262,7 +2426,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G2, false), nmeaBuffer);
 
     // ---------------------
     // ------$GAGSV:E1------
@@ -2270,21 +2434,21 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E1, false), nmeaBuffer);
 
     // -------------------------
     // ------$GAGSV:E5A---------
     // -------------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5A, false), nmeaBuffer);
 
     // -------------------------
     // ------$GAGSV:E5B---------
     // -------------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5B, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5B, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L1CA-----
@@ -2292,7 +2456,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L1CA, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L5-------
@@ -2300,7 +2464,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L5, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L2-------
@@ -2308,7 +2472,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L2, false), nmeaBuffer);
 
 
     // -----------------------------
@@ -2317,7 +2481,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B1C)----
@@ -2325,7 +2489,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B2AI)---
@@ -2333,7 +2497,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaBuffer);
 
     // -----------------------------
     // ------$GIGSV (NAVIC:L5)------
@@ -2341,7 +2505,58 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+            GNSS_SIGNAL_NAVIC_L5,false), nmeaBuffer);
 
     EXIT_LOG(%d, 0);
 }
+
+/*===========================================================================
+FUNCTION    loc_nmea_generate_sv / loc_nmea_generate_pos
+
+DESCRIPTION
+   Same as above, with each sentence in its own string
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   0
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static void loc_nmea_split(const LocNmeaBuffer &nmeaBuffer,
+                           std::vector<std::string> &nmeaArraystr)
+{
+    for (size_t i = 0; i < nmeaBuffer.count(); i++) {
+        nmeaArraystr.emplace_back(nmeaBuffer.sentence(i), nmeaBuffer.sentenceLength(i));
+    }
+}
+
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              std::vector<std::string> &nmeaArraystr)
+{
+    LocNmeaBuffer nmeaBuffer;
+    loc_nmea_generate_sv(svNotify, nmeaBuffer);
+    loc_nmea_split(nmeaBuffer, nmeaArraystr);
+}
+
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               std::vector<std::string> &nmeaArraystr,
+                               int& indexOfGGA,
+                               bool isTagBlockGroupingEnabled)
+{
+    LocNmeaBuffer nmeaBuffer;
+    loc_nmea_generate_pos(location, locationExtended, systemInfo, generate_nmea,
+                          custom_gga_fix_quality, nmeaBuffer, indexOfGGA,
+                          isTagBlockGroupingEnabled);
+    if (-1 != indexOfGGA) {
+        indexOfGGA += static_cast<int>(nmeaArraystr.size());
+    }
+    loc_nmea_split(nmeaBuffer, nmeaArraystr);
+}
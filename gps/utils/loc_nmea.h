@@ -72,6 +72,49 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/* Sentences of one NMEA report, back to back in one buffer. Meant to be
+   kept and reused, clear() keeps the memory, so once it has grown to the
+   size of a report, generating one allocates nothing. */
+class LocNmeaBuffer {
+public:
+    inline void clear() {
+        mData.clear();
+        mOffsets.clear();
+    }
+    inline void append(const char* sentence) {
+        mOffsets.push_back(mData.size());
+        mData.append(sentence);
+    }
+    // all sentences, NUL terminated
+    inline const char* data() const { return mData.c_str(); }
+    inline size_t length() const { return mData.size(); }
+    inline size_t count() const { return mOffsets.size(); }
+    // i-th sentence, not NUL terminated
+    inline const char* sentence(size_t i) const { return mData.data() + mOffsets[i]; }
+    inline size_t sentenceLength(size_t i) const {
+        return ((i + 1 < mOffsets.size()) ? mOffsets[i + 1] : mData.size()) - mOffsets[i];
+    }
+
+private:
+    std::string mData;
+    std::vector<size_t> mOffsets;
+};
+
+/* both append to nmeaBuffer; indexOfGGA is the index of the GGA sentence
+   in nmeaBuffer, or -1 */
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              LocNmeaBuffer &nmeaBuffer);
+
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               LocNmeaBuffer &nmeaBuffer,
+                               int& indexOfGGA,
+                               bool isTagBlockGroupingEnabled);
+
+/* as above, one string per sentence */
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
                               std::vector<std::string> &nmeaArraystr);
 
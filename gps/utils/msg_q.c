@@ -31,17 +31,55 @@
 #define LOG_TAG "LocSvc_utils_q"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <loc_pla.h>
 #include <log_util.h>
 #include "linked_list.h"
 #include "msg_q.h"
 
+#define MSG_Q_CACHE_LINE_SIZE 64
+
+typedef struct msg_q_ring_slot {
+   atomic_size_t seq;               /* Slot sequence, tells producers and consumer who owns it */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_ring_slot;
+
+typedef struct msg_q_ring {
+   msg_q_ring_slot* slots;
+   size_t mask;                     /* Ring capacity - 1, capacity is a power of 2 */
+   char pad0[MSG_Q_CACHE_LINE_SIZE];
+   atomic_size_t enqueue_pos;       /* Claimed by producers with CAS */
+   char pad1[MSG_Q_CACHE_LINE_SIZE];
+   atomic_size_t dequeue_pos;       /* Advanced by the receiving side */
+   char pad2[MSG_Q_CACHE_LINE_SIZE];
+} msg_q_ring;
+
+typedef struct msg_q_lane {
+   void* msg_list;                  /* Linked list storage, or ring spill over */
+   msg_q_ring* ring;                /* Lock free ring, NULL for the plain linked list queue */
+   atomic_uint overflow_cnt;        /* Elements spilled into msg_list while the ring was full */
+   atomic_uint depth;               /* Elements currently queued in this lane */
+   atomic_uint max_depth;           /* High water mark of depth */
+   unsigned int skipped;            /* Receives served by other lanes while this one waited */
+} msg_q_lane;
+
 typedef struct msg_q {
-   void* msg_list;                  /* Linked list to store information */
+   msg_q_lane lanes[eMSG_Q_LANE_COUNT];
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
-   int unblocked;                   /* Has this message queue been unblocked? */
+   atomic_int unblocked;            /* Has this message queue been unblocked? */
+   atomic_int parked;               /* Ring queues: futex word, 1 while the receiver sleeps */
+   bool is_ring;                    /* Lanes are lock free rings instead of linked lists */
 } msg_q;
 
 /*===========================================================================
@@ -85,14 +123,366 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
-/* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
+/*===========================================================================
+FUNCTION    msg_q_lane_added / msg_q_lane_removed
+
+DESCRIPTION
+   Book keeping of the per lane depth, done after an element is made
+   available to, or taken away from, the receiving side.
+
+===========================================================================*/
+static void msg_q_lane_added(msg_q_lane* lane)
+{
+   unsigned int depth = atomic_fetch_add(&lane->depth, 1) + 1;
+   unsigned int max_depth = atomic_load_explicit(&lane->max_depth, memory_order_relaxed);
+   while (depth > max_depth &&
+          !atomic_compare_exchange_weak_explicit(&lane->max_depth, &max_depth, depth,
+                                                 memory_order_relaxed, memory_order_relaxed))
+   {
+   }
+}
+
+static void msg_q_lane_removed(msg_q_lane* lane)
+{
+   atomic_fetch_sub(&lane->depth, 1);
+}
 
 /*===========================================================================
+FUNCTION    msg_q_pick_lane
 
-  FUNCTION:   msg_q_init
+DESCRIPTION
+   Picks the lane the next element is received from: the highest priority
+   non empty lane, unless a lower priority lane has been passed over
+   MSG_Q_LANE_STARVATION_LIMIT times in a row, in which case that one is
+   served once. Must be called by the receiving side only (under the list
+   mutex for list queues).
 
-  ===========================================================================*/
-msq_q_err_type msg_q_init(void** msg_q_data)
+RETURN VALUE
+   lane index, or -1 if all lanes are empty
+
+===========================================================================*/
+static int msg_q_pick_lane(msg_q* p_msg_q)
+{
+   int pick = -1;
+   int i;
+
+   for (i = 0; i < eMSG_Q_LANE_COUNT; i++)
+   {
+      msg_q_lane* lane = &p_msg_q->lanes[i];
+      if (0 == atomic_load(&lane->depth))
+      {
+         lane->skipped = 0;
+      }
+      else if (pick < 0 || lane->skipped >= MSG_Q_LANE_STARVATION_LIMIT)
+      {
+         pick = i;
+      }
+   }
+
+   for (i = 0; pick >= 0 && i < eMSG_Q_LANE_COUNT; i++)
+   {
+      if (i == pick)
+      {
+         p_msg_q->lanes[i].skipped = 0;
+      }
+      else if (0 != atomic_load(&p_msg_q->lanes[i].depth))
+      {
+         p_msg_q->lanes[i].skipped++;
+      }
+   }
+
+   return pick;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_push / msg_q_ring_pop
+
+DESCRIPTION
+   Bounded lock free ring in the style of D. Vyukov's MPMC queue. Each slot
+   carries a sequence number; a producer owns slot (pos & mask) when its
+   seq == pos, and the receiving side owns it when seq == pos + 1. Neither
+   side ever blocks, a full ring makes push fail and an empty one makes pop
+   fail.
+
+RETURN VALUE
+   true if an element was pushed / popped
+
+===========================================================================*/
+static bool msg_q_ring_push(msg_q_ring* ring, void* msg_obj, void (*dealloc)(void*))
+{
+   size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+   for (;;)
+   {
+      msg_q_ring_slot* slot = &ring->slots[pos & ring->mask];
+      size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (0 == diff)
+      {
+         if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                   memory_order_relaxed, memory_order_relaxed))
+         {
+            slot->msg_obj = msg_obj;
+            slot->dealloc = dealloc;
+            atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+            return true;
+         }
+      }
+      else if (diff < 0)
+      {
+         return false;
+      }
+      else
+      {
+         pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+      }
+   }
+}
+
+static bool msg_q_ring_pop(msg_q_ring* ring, void** msg_obj, void (**dealloc)(void*))
+{
+   size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+   for (;;)
+   {
+      msg_q_ring_slot* slot = &ring->slots[pos & ring->mask];
+      size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (0 == diff)
+      {
+         if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &pos, pos + 1,
+                                                   memory_order_relaxed, memory_order_relaxed))
+         {
+            *msg_obj = slot->msg_obj;
+            if (NULL != dealloc)
+            {
+               *dealloc = slot->dealloc;
+            }
+            atomic_store_explicit(&slot->seq, pos + ring->mask + 1, memory_order_release);
+            return true;
+         }
+      }
+      else if (diff < 0)
+      {
+         return false;
+      }
+      else
+      {
+         pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+      }
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_wake
+
+DESCRIPTION
+   Wakes up the receiver if it is parked. Must be called after the element
+   is published; the seq_cst fence pairs with the one in msg_q_ring_rcv so
+   that either the producer sees parked == 1, or the receiver sees the
+   element before it goes to sleep.
+
+===========================================================================*/
+static void msg_q_ring_wake(msg_q* p_msg_q)
+{
+   atomic_thread_fence(memory_order_seq_cst);
+   if (atomic_load_explicit(&p_msg_q->parked, memory_order_relaxed) &&
+       atomic_exchange(&p_msg_q->parked, 0))
+   {
+      syscall(SYS_futex, &p_msg_q->parked, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_snd
+
+DESCRIPTION
+   Fast path of msg_q_snd for ring queues. If the lane's ring is full, or
+   elements have already spilled over, the element is appended to the
+   lane's locked list so that nothing is ever dropped and per producer
+   ordering is preserved.
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_snd(msg_q* p_msg_q, msg_q_lane* lane,
+                                     void* msg_obj, void (*dealloc)(void*))
+{
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+
+   if (0 != atomic_load(&lane->overflow_cnt) || !msg_q_ring_push(lane->ring, msg_obj, dealloc))
+   {
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+      rv = convert_linked_list_err_type(linked_list_add(lane->msg_list, msg_obj, dealloc));
+      if (eMSG_Q_SUCCESS == rv)
+      {
+         atomic_fetch_add(&lane->overflow_cnt, 1);
+      }
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      LOC_LOGV("%s: ring full, message %p spilled over\n", __FUNCTION__, msg_obj);
+   }
+
+   if (eMSG_Q_SUCCESS == rv)
+   {
+      msg_q_lane_added(lane);
+      msg_q_ring_wake(p_msg_q);
+   }
+
+   return rv;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_take
+
+DESCRIPTION
+   Non blocking removal of the oldest element of a ring queue lane, ring
+   first, then whatever has spilled over into the locked list.
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_take(msg_q* p_msg_q, msg_q_lane* lane, void** msg_obj)
+{
+   msq_q_err_type rv = eMSG_Q_EMPTY;
+
+   if (msg_q_ring_pop(lane->ring, msg_obj, NULL))
+   {
+      rv = eMSG_Q_SUCCESS;
+   }
+   else if (0 != atomic_load(&lane->overflow_cnt))
+   {
+      pthread_mutex_lock(&p_msg_q->list_mutex);
+      rv = convert_linked_list_err_type(linked_list_remove(lane->msg_list, msg_obj));
+      if (eMSG_Q_SUCCESS == rv)
+      {
+         atomic_fetch_sub(&lane->overflow_cnt, 1);
+      }
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+   }
+
+   if (eMSG_Q_SUCCESS == rv)
+   {
+      msg_q_lane_removed(lane);
+   }
+
+   return rv;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_rmv
+
+DESCRIPTION
+   Non blocking removal of the next element of a ring queue, lane chosen by
+   msg_q_pick_lane.
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_rmv(msg_q* p_msg_q, void** msg_obj)
+{
+   int lane = msg_q_pick_lane(p_msg_q);
+   if (lane < 0)
+   {
+      return eMSG_Q_EMPTY;
+   }
+   return msg_q_ring_take(p_msg_q, &p_msg_q->lanes[lane], msg_obj);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_rcv
+
+DESCRIPTION
+   Blocking receive for ring queues. The receiver announces itself in the
+   parked futex word, re-checks the queue and only then sleeps, so producers
+   only pay for a syscall when the receiver is actually idle. If deadline is
+   not NULL, gives up with eMSG_Q_TIMEOUT once CLOCK_MONOTONIC passes it.
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_rcv(msg_q* p_msg_q, void** msg_obj,
+                                     const struct timespec* deadline)
+{
+   msq_q_err_type rv;
+
+   for (;;)
+   {
+      rv = msg_q_ring_rmv(p_msg_q, msg_obj);
+      if (eMSG_Q_SUCCESS == rv)
+      {
+         break;
+      }
+      if (atomic_load(&p_msg_q->unblocked))
+      {
+         rv = eMSG_Q_UNAVAILABLE_RESOURCE;
+         break;
+      }
+
+      if (0 == atomic_load(&p_msg_q->parked))
+      {
+         /* announce, then look once more before going to sleep */
+         atomic_store(&p_msg_q->parked, 1);
+         atomic_thread_fence(memory_order_seq_cst);
+      }
+      else if (deadline == NULL)
+      {
+         syscall(SYS_futex, &p_msg_q->parked, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+      }
+      else
+      {
+         /* FUTEX_WAIT takes a CLOCK_MONOTONIC relative timeout */
+         struct timespec now, timeout;
+         clock_gettime(CLOCK_MONOTONIC, &now);
+         timeout.tv_sec = deadline->tv_sec - now.tv_sec;
+         timeout.tv_nsec = deadline->tv_nsec - now.tv_nsec;
+         if (timeout.tv_nsec < 0)
+         {
+            timeout.tv_sec--;
+            timeout.tv_nsec += 1000000000L;
+         }
+         if (timeout.tv_sec < 0)
+         {
+            rv = eMSG_Q_TIMEOUT;
+            break;
+         }
+         syscall(SYS_futex, &p_msg_q->parked, FUTEX_WAIT_PRIVATE, 1, &timeout, NULL, 0);
+      }
+   }
+
+   atomic_store(&p_msg_q->parked, 0);
+
+   return rv;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_lane_flush
+
+DESCRIPTION
+   Removes and deallocates every element of one lane.
+
+===========================================================================*/
+static msq_q_err_type msg_q_lane_flush(msg_q* p_msg_q, msg_q_lane* lane)
+{
+   void* msg_obj = NULL;
+   void (*dealloc)(void*) = NULL;
+   msq_q_err_type rv;
+
+   while (NULL != lane->ring && NULL != lane->ring->slots &&
+          msg_q_ring_pop(lane->ring, &msg_obj, &dealloc))
+   {
+      if (NULL != dealloc)
+      {
+         dealloc(msg_obj);
+      }
+   }
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+   rv = convert_linked_list_err_type(linked_list_flush(lane->msg_list));
+   atomic_store(&lane->overflow_cnt, 0);
+   atomic_store(&lane->depth, 0);
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   return rv;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_alloc
+
+DESCRIPTION
+   Common part of msg_q_init and msg_q_init_ring.
+
+===========================================================================*/
+static msq_q_err_type msg_q_alloc(void** msg_q_data, uint32_t ring_capacity)
 {
    if( msg_q_data == NULL )
    {
@@ -108,37 +498,89 @@ msq_q_err_type msg_q_init(void** msg_q_data)
       return eMSG_Q_FAILURE_GENERAL;
    }
 
-   if( linked_list_init(&tmp_msg_q->msg_list) != 0 )
-   {
-      LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
-      free(tmp_msg_q);
-      return eMSG_Q_FAILURE_GENERAL;
-   }
-
+   /* from here on msg_q_destroy can clean up a partially built queue */
    if( pthread_mutex_init(&tmp_msg_q->list_mutex, NULL) != 0 )
    {
       LOC_LOGE("%s: Unable to initialize list mutex!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
 
-   if( pthread_cond_init(&tmp_msg_q->list_cond, NULL) != 0 )
+   /* timed receives wait against CLOCK_MONOTONIC */
+   pthread_condattr_t cond_attr;
+   pthread_condattr_init(&cond_attr);
+   pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+   int cond_rv = pthread_cond_init(&tmp_msg_q->list_cond, &cond_attr);
+   pthread_condattr_destroy(&cond_attr);
+   if( cond_rv != 0 )
    {
       LOC_LOGE("%s: Unable to initialize msg q cond var!\n", __FUNCTION__);
-      linked_list_destroy(&tmp_msg_q->msg_list);
       pthread_mutex_destroy(&tmp_msg_q->list_mutex);
       free(tmp_msg_q);
       return eMSG_Q_FAILURE_GENERAL;
    }
 
-   tmp_msg_q->unblocked = 0;
+   atomic_init(&tmp_msg_q->unblocked, 0);
+   atomic_init(&tmp_msg_q->parked, 0);
+   tmp_msg_q->is_ring = (ring_capacity > 0);
+
+   size_t size = 2;
+   while( size < ring_capacity && size < MSG_Q_RING_MAX_CAPACITY )
+   {
+      size <<= 1;
+   }
+
+   for( int i = 0; i < eMSG_Q_LANE_COUNT; i++ )
+   {
+      msg_q_lane* lane = &tmp_msg_q->lanes[i];
+      atomic_init(&lane->overflow_cnt, 0);
+      atomic_init(&lane->depth, 0);
+      atomic_init(&lane->max_depth, 0);
+
+      if( linked_list_init(&lane->msg_list) != 0 )
+      {
+         LOC_LOGE("%s: Unable to initialize storage list!\n", __FUNCTION__);
+         msg_q_destroy((void**)&tmp_msg_q);
+         return eMSG_Q_FAILURE_GENERAL;
+      }
+
+      if( tmp_msg_q->is_ring )
+      {
+         lane->ring = (msg_q_ring*)calloc(1, sizeof(msg_q_ring));
+         if( lane->ring == NULL ||
+             (lane->ring->slots = (msg_q_ring_slot*)calloc(size, sizeof(msg_q_ring_slot))) == NULL )
+         {
+            LOC_LOGE("%s: Unable to allocate space for ring of %zu!\n", __FUNCTION__, size);
+            msg_q_destroy((void**)&tmp_msg_q);
+            return eMSG_Q_FAILURE_GENERAL;
+         }
+         for( size_t j = 0; j < size; j++ )
+         {
+            atomic_init(&lane->ring->slots[j].seq, j);
+         }
+         lane->ring->mask = size - 1;
+         atomic_init(&lane->ring->enqueue_pos, 0);
+         atomic_init(&lane->ring->dequeue_pos, 0);
+      }
+   }
 
    *msg_q_data = tmp_msg_q;
 
    return eMSG_Q_SUCCESS;
 }
 
+/* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init
+
+  ===========================================================================*/
+msq_q_err_type msg_q_init(void** msg_q_data)
+{
+   return msg_q_alloc(msg_q_data, 0);
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_init2
@@ -153,6 +595,30 @@ const void* msg_q_init2()
   return q;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_init_ring
+
+  ===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, uint32_t capacity)
+{
+   return msg_q_alloc(msg_q_data, capacity > 0 ? capacity : 1);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init_ring2
+
+  ===========================================================================*/
+const void* msg_q_init_ring2(uint32_t capacity)
+{
+  void* q = NULL;
+  if (eMSG_Q_SUCCESS != msg_q_init_ring(&q, capacity)) {
+    q = NULL;
+  }
+  return q;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -168,7 +634,21 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
 
    msg_q* p_msg_q = (msg_q*)*msg_q_data;
 
-   linked_list_destroy(&p_msg_q->msg_list);
+   for( int i = 0; i < eMSG_Q_LANE_COUNT; i++ )
+   {
+      msg_q_lane* lane = &p_msg_q->lanes[i];
+      if( lane->msg_list != NULL )
+      {
+         msg_q_lane_flush(p_msg_q, lane);
+         linked_list_destroy(&lane->msg_list);
+      }
+      if( lane->ring != NULL )
+      {
+         free(lane->ring->slots);
+         free(lane->ring);
+         lane->ring = NULL;
+      }
+   }
    pthread_mutex_destroy(&p_msg_q->list_mutex);
    pthread_cond_destroy(&p_msg_q->list_cond);
 
@@ -186,6 +666,17 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
 
   ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*))
+{
+   return msg_q_snd_lane(msg_q_data, msg_obj, dealloc, eMSG_Q_LANE_NORMAL);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_snd_lane
+
+  ===========================================================================*/
+msq_q_err_type msg_q_snd_lane(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                              msg_q_lane_type lane)
 {
    msq_q_err_type rv;
    if( msg_q_data == NULL )
@@ -193,13 +684,24 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
       return eMSG_Q_INVALID_HANDLE;
    }
-   if( msg_obj == NULL )
+   if( msg_obj == NULL || lane < 0 || lane >= eMSG_Q_LANE_COUNT )
    {
-      LOC_LOGE("%s: Invalid msg_obj parameter!\n", __FUNCTION__);
+      LOC_LOGE("%s: Invalid msg_obj %p or lane %d parameter!\n", __FUNCTION__, msg_obj, lane);
       return eMSG_Q_INVALID_PARAMETER;
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
+   msg_q_lane* p_lane = &p_msg_q->lanes[lane];
+
+   if( p_msg_q->is_ring )
+   {
+      if( atomic_load(&p_msg_q->unblocked) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+      return msg_q_ring_snd(p_msg_q, p_lane, msg_obj, dealloc);
+   }
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
    LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
@@ -211,7 +713,11 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
-   rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
+   rv = convert_linked_list_err_type(linked_list_add(p_lane->msg_list, msg_obj, dealloc));
+   if( rv == eMSG_Q_SUCCESS )
+   {
+      msg_q_lane_added(p_lane);
+   }
 
    /* Show data is in the message queue. */
    pthread_cond_signal(&p_msg_q->list_cond);
@@ -225,10 +731,110 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
 
 /*===========================================================================
 
-  FUNCTION:   msg_q_rcv
+  FUNCTION:   msg_q_snd_batch
 
   ===========================================================================*/
-msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
+msq_q_err_type msg_q_snd_batch(void* msg_q_data, void** msg_objs, const msg_q_lane_type* lanes,
+                               uint32_t count, void (*dealloc)(void*))
+{
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
+   uint32_t i;
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+   if( msg_objs == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_objs parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+   for( i = 0; i < count; i++ )
+   {
+      if( msg_objs[i] == NULL ||
+          (lanes != NULL && (lanes[i] < 0 || lanes[i] >= eMSG_Q_LANE_COUNT)) )
+      {
+         LOC_LOGE("%s: Invalid msg_obj or lane at %u!\n", __FUNCTION__, i);
+         return eMSG_Q_INVALID_PARAMETER;
+      }
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+
+   if( p_msg_q->is_ring )
+   {
+      if( atomic_load(&p_msg_q->unblocked) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+      /* msg_q_ring_snd only makes a syscall for the first one, if at all */
+      for( i = 0; i < count && rv == eMSG_Q_SUCCESS; i++ )
+      {
+         msg_q_lane* p_lane = &p_msg_q->lanes[lanes != NULL ? lanes[i] : eMSG_Q_LANE_NORMAL];
+         rv = msg_q_ring_snd(p_msg_q, p_lane, msg_objs[i], dealloc);
+      }
+      return rv;
+   }
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+   LOC_LOGV("%s: Sending %u messages\n", __FUNCTION__, count);
+
+   if( p_msg_q->unblocked )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   for( i = 0; i < count && rv == eMSG_Q_SUCCESS; i++ )
+   {
+      msg_q_lane* p_lane = &p_msg_q->lanes[lanes != NULL ? lanes[i] : eMSG_Q_LANE_NORMAL];
+      rv = convert_linked_list_err_type(linked_list_add(p_lane->msg_list, msg_objs[i], dealloc));
+      if( rv == eMSG_Q_SUCCESS )
+      {
+         msg_q_lane_added(p_lane);
+      }
+   }
+
+   /* Show data is in the message queue. */
+   pthread_cond_signal(&p_msg_q->list_cond);
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   return rv;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_deadline
+
+DESCRIPTION
+   Converts a timeout in ms from now into an absolute CLOCK_MONOTONIC time.
+
+===========================================================================*/
+static void msg_q_deadline(uint32_t timeout_ms, struct timespec* deadline)
+{
+   clock_gettime(CLOCK_MONOTONIC, deadline);
+   deadline->tv_sec += timeout_ms / 1000;
+   deadline->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+   if( deadline->tv_nsec >= 1000000000L )
+   {
+      deadline->tv_sec++;
+      deadline->tv_nsec -= 1000000000L;
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_rcv_common
+
+DESCRIPTION
+   Shared by the msg_q_rcv flavors: waits until an element is available,
+   the queue is unblocked or, if deadline is not NULL, CLOCK_MONOTONIC
+   passes deadline; then takes up to max_count elements.
+
+===========================================================================*/
+static msq_q_err_type msg_q_rcv_common(void* msg_q_data, void** msg_objs, uint32_t max_count,
+                                       uint32_t* count, const struct timespec* deadline)
 {
    msq_q_err_type rv;
    if( msg_q_data == NULL )
@@ -237,13 +843,35 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_INVALID_HANDLE;
    }
 
-   if( msg_obj == NULL )
+   if( msg_objs == NULL || count == NULL || max_count == 0 )
    {
-      LOC_LOGE("%s: Invalid msg_obj parameter!\n", __FUNCTION__);
+      LOC_LOGE("%s: Invalid msg_objs, max_count or count parameter!\n", __FUNCTION__);
       return eMSG_Q_INVALID_PARAMETER;
    }
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
+   *count = 0;
+
+   if( p_msg_q->is_ring )
+   {
+      if( atomic_load(&p_msg_q->unblocked) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+      /* block for the first one only */
+      rv = msg_q_ring_rcv(p_msg_q, &msg_objs[0], deadline);
+      if( rv == eMSG_Q_SUCCESS )
+      {
+         *count = 1;
+         while( *count < max_count &&
+                msg_q_ring_rmv(p_msg_q, &msg_objs[*count]) == eMSG_Q_SUCCESS )
+         {
+            (*count)++;
+         }
+      }
+      return rv;
+   }
 
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
@@ -255,20 +883,101 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    }
 
    /* Wait for data in the message queue */
-   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   int lane;
+   bool timed_out = false;
+   while( (lane = msg_q_pick_lane(p_msg_q)) < 0 && !p_msg_q->unblocked && !timed_out )
    {
-      pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+      if( deadline == NULL )
+      {
+         pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+      }
+      else
+      {
+         timed_out = (ETIMEDOUT ==
+               pthread_cond_timedwait(&p_msg_q->list_cond, &p_msg_q->list_mutex, deadline));
+      }
    }
 
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   if( lane >= 0 )
+   {
+      rv = eMSG_Q_SUCCESS;
+   }
+   else
+   {
+      rv = p_msg_q->unblocked ? eMSG_Q_UNAVAILABLE_RESOURCE : eMSG_Q_TIMEOUT;
+   }
+
+   /* take as many as we can while holding the lock */
+   while( lane >= 0 && *count < max_count )
+   {
+      if( linked_list_remove(p_msg_q->lanes[lane].msg_list, &msg_objs[*count]) !=
+          eLINKED_LIST_SUCCESS )
+      {
+         break;
+      }
+      msg_q_lane_removed(&p_msg_q->lanes[lane]);
+      (*count)++;
+      if( *count < max_count )
+      {
+         lane = msg_q_pick_lane(p_msg_q);
+      }
+   }
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
-   LOC_LOGV("%s: Received message %p rv = %d\n", __FUNCTION__, *msg_obj, rv);
+   LOC_LOGV("%s: Received %u messages rv = %d\n", __FUNCTION__, *count, rv);
 
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
+{
+   uint32_t count;
+   return msg_q_rcv_common(msg_q_data, msg_obj, 1, &count, NULL);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_timed
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_timed(void* msg_q_data, void** msg_obj, uint32_t timeout_ms)
+{
+   uint32_t count;
+   struct timespec deadline;
+   msg_q_deadline(timeout_ms, &deadline);
+   return msg_q_rcv_common(msg_q_data, msg_obj, 1, &count, &deadline);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_batch
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs, uint32_t max_count,
+                               uint32_t* count)
+{
+   return msg_q_rcv_common(msg_q_data, msg_objs, max_count, count, NULL);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_batch_timed
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_batch_timed(void* msg_q_data, void** msg_objs, uint32_t max_count,
+                                     uint32_t* count, uint32_t timeout_ms)
+{
+   struct timespec deadline;
+   msg_q_deadline(timeout_ms, &deadline);
+   return msg_q_rcv_common(msg_q_data, msg_objs, max_count, count, &deadline);
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rmv
@@ -289,6 +998,14 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if (p_msg_q->is_ring) {
+      if (atomic_load(&p_msg_q->unblocked)) {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+      return msg_q_ring_rmv(p_msg_q, msg_obj);
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if (p_msg_q->unblocked) {
@@ -297,13 +1014,17 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
       return eMSG_Q_UNAVAILABLE_RESOURCE;
    }
 
-   if (linked_list_empty(p_msg_q->msg_list)) {
+   int lane = msg_q_pick_lane(p_msg_q);
+   if (lane < 0) {
       LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
       pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eMSG_Q_EMPTY;
    }
 
-   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+   rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->lanes[lane].msg_list, msg_obj));
+   if (rv == eMSG_Q_SUCCESS) {
+      msg_q_lane_removed(&p_msg_q->lanes[lane]);
+   }
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -321,7 +1042,7 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
   ===========================================================================*/
 msq_q_err_type msg_q_flush(void* msg_q_data)
 {
-   msq_q_err_type rv;
+   msq_q_err_type rv = eMSG_Q_SUCCESS;
    if ( msg_q_data == NULL )
    {
       LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
@@ -332,12 +1053,15 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
-   pthread_mutex_lock(&p_msg_q->list_mutex);
-
-   /* Remove all elements from the list */
-   rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
-
-   pthread_mutex_unlock(&p_msg_q->list_mutex);
+   /* Remove all elements from all the lanes */
+   for( int i = 0; i < eMSG_Q_LANE_COUNT; i++ )
+   {
+      msq_q_err_type lane_rv = msg_q_lane_flush(p_msg_q, &p_msg_q->lanes[i]);
+      if( lane_rv != eMSG_Q_SUCCESS )
+      {
+         rv = lane_rv;
+      }
+   }
 
    LOC_LOGD("%s: Message Queue flushed\n", __FUNCTION__);
 
@@ -373,6 +1097,10 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    /* Allow all the waiters to wake up */
    pthread_cond_broadcast(&p_msg_q->list_cond);
+   if( p_msg_q->is_ring )
+   {
+      msg_q_ring_wake(p_msg_q);
+   }
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -380,3 +1108,35 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    return eMSG_Q_SUCCESS;
 }
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_get_lane_depth
+
+  ===========================================================================*/
+msq_q_err_type msg_q_get_lane_depth(void* msg_q_data, msg_q_lane_type lane,
+                                    uint32_t* depth, uint32_t* max_depth)
+{
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+   if( lane < 0 || lane >= eMSG_Q_LANE_COUNT )
+   {
+      LOC_LOGE("%s: Invalid lane %d!\n", __FUNCTION__, lane);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+   if( depth != NULL )
+   {
+      *depth = atomic_load(&p_msg_q->lanes[lane].depth);
+   }
+   if( max_depth != NULL )
+   {
+      *max_depth = atomic_load(&p_msg_q->lanes[lane].max_depth);
+   }
+
+   return eMSG_Q_SUCCESS;
+}
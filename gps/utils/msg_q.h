@@ -34,6 +34,10 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <stdlib.h>
+#include <stdint.h>
+
+/** Upper bound of the capacity accepted by msg_q_init_ring */
+#define MSG_Q_RING_MAX_CAPACITY (1 << 16)
 
 /** Linked List Return Codes */
 typedef enum
@@ -50,10 +54,28 @@ typedef enum
      /**< Failed because an there were not enough resources. */
   eMSG_Q_INSUFFICIENT_BUFFER                 = -5,
      /**< Failed because an the supplied buffer was too small. */
-  eMSG_Q_EMPTY                               = -6
+  eMSG_Q_EMPTY                               = -6,
      /**< Failed because list is empty. */
+  eMSG_Q_TIMEOUT                             = -7
+     /**< Failed because nothing was received before the timeout. */
 }msq_q_err_type;
 
+/** Message Queue Lanes, in the order they are served */
+typedef enum
+{
+  eMSG_Q_LANE_HIGH                           = 0,
+     /**< Time critical elements, served ahead of everything else. */
+  eMSG_Q_LANE_NORMAL                         = 1,
+     /**< Default lane, used by msg_q_snd. */
+  eMSG_Q_LANE_BACKGROUND                     = 2,
+     /**< Bulk work that can wait. */
+  eMSG_Q_LANE_COUNT
+}msg_q_lane_type;
+
+/** Number of consecutive receives a non empty lane can be passed over by
+    higher priority lanes before it is served once regardless */
+#define MSG_Q_LANE_STARVATION_LIMIT 8
+
 /*===========================================================================
 FUNCTION    msg_q_init
 
@@ -92,6 +114,51 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init_ring
+
+DESCRIPTION
+   Initializes a message queue backed by a bounded lock free ring instead of
+   a mutex protected linked list. Senders never take a lock nor allocate
+   while the ring has room, and the receiver is only woken up through a
+   futex when it is actually parked. Should the ring fill up, elements spill
+   over into a locked list so that msg_q_snd never drops a message. All the
+   other msg_q_* functions work the same on both kinds of queue.
+
+   msg_q_data: pointer to an opaque Q handle to be returned; NULL if fails
+   capacity:   number of ring slots, rounded up to a power of 2 and capped at
+               MSG_Q_RING_MAX_CAPACITY
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, uint32_t capacity);
+
+/*===========================================================================
+FUNCTION    msg_q_init_ring2
+
+DESCRIPTION
+   Initializes a lock free ring message queue, see msg_q_init_ring.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   opaque handle to the Q created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_q_init_ring2(uint32_t capacity);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 
@@ -137,6 +204,62 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*));
 
+/*===========================================================================
+FUNCTION    msg_q_snd_lane
+
+DESCRIPTION
+   Same as msg_q_snd, but adds the element to the given lane. Elements are
+   FIFO within a lane; across lanes msg_q_rcv returns elements of the
+   highest priority non empty lane first, except that a lane passed over
+   MSG_Q_LANE_STARVATION_LIMIT times in a row is served once.
+
+   msg_q_data: Message Queue to add the element to.
+   msgp:       Pointer to data to add into message queue.
+   dealloc:    Function used to deallocate memory for this element. Pass NULL
+               if you do not want data deallocated during a flush operation
+   lane:       Lane to add the element to.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_snd_lane(void* msg_q_data, void* msg_obj, void (*dealloc)(void*),
+                              msg_q_lane_type lane);
+
+/*===========================================================================
+FUNCTION    msg_q_snd_batch
+
+DESCRIPTION
+   Sends count elements at once, taking the queue lock and waking up the
+   receiver a single time. Elements are added in array order.
+
+   msg_q_data: Message Queue to add the elements to.
+   msg_objs:   Array of count pointers to data to add into message queue.
+   lanes:      Array of count lanes, one per element; NULL for all normal.
+   count:      Number of elements.
+   dealloc:    Function used to deallocate memory for these elements. Pass
+               NULL if you do not want data deallocated during a flush
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above. On failure, elements from the failing one
+   on are not added.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_snd_batch(void* msg_q_data, void** msg_objs, const msg_q_lane_type* lanes,
+                               uint32_t count, void (*dealloc)(void*));
+
 /*===========================================================================
 FUNCTION    msg_q_rcv
 
@@ -159,6 +282,75 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj);
 
+/*===========================================================================
+FUNCTION    msg_q_rcv_timed
+
+DESCRIPTION
+   Same as msg_q_rcv, except that it gives up once timeout_ms have elapsed,
+   measured on CLOCK_MONOTONIC, without anything to receive.
+
+   msg_q_data: Message Queue to copy data from into msgp.
+   msg_obj:    Pointer to space to copy msg_q contents to.
+   timeout_ms: Max time to wait, in ms.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above. eMSG_Q_TIMEOUT if the timeout elapsed.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_timed(void* msg_q_data, void** msg_obj, uint32_t timeout_ms);
+
+/*===========================================================================
+FUNCTION    msg_q_rcv_batch
+
+DESCRIPTION
+   Same as msg_q_rcv, except that once at least one element is available,
+   up to max_count elements are taken out while holding the queue lock a
+   single time, in the same order msg_q_rcv would have returned them.
+
+   msg_q_data: Message Queue to copy data from into msg_objs.
+   msg_objs:   Array of max_count pointers to receive the elements.
+   max_count:  Size of msg_objs.
+   count:      Number of elements returned in msg_objs.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_batch(void* msg_q_data, void** msg_objs, uint32_t max_count,
+                               uint32_t* count);
+
+/*===========================================================================
+FUNCTION    msg_q_rcv_batch_timed
+
+DESCRIPTION
+   Same as msg_q_rcv_batch, except that it gives up once timeout_ms have
+   elapsed, measured on CLOCK_MONOTONIC, without anything to receive.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above. eMSG_Q_TIMEOUT if the timeout elapsed.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_batch_timed(void* msg_q_data, void** msg_objs, uint32_t max_count,
+                                     uint32_t* count, uint32_t timeout_ms);
+
 /*===========================================================================
 FUNCTION    msg_q_rmv
 
@@ -225,6 +417,31 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_unblock(void* msg_q_data);
 
+/*===========================================================================
+FUNCTION    msg_q_get_lane_depth
+
+DESCRIPTION
+   Reads the number of elements currently queued in a lane, and the largest
+   number ever queued in it since the message queue was initialized.
+
+   msg_q_data: Message queue to query.
+   lane:       Lane to query.
+   depth:      Current depth; may be NULL.
+   max_depth:  High water mark; may be NULL.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_get_lane_depth(void* msg_q_data, msg_q_lane_type lane,
+                                    uint32_t* depth, uint32_t* max_depth);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -150,6 +150,7 @@ public:
     inline virtual const char* getName() const override {
         return mServiceInfo.getName();
     }
+    inline virtual int getFd() const override { return mSock->mSid; }
     inline virtual void abort() const override {
         if (isSendable()) {
             serviceLookup();
@@ -356,6 +357,7 @@ public:
     inline virtual const char* getName() const override {
         return mServiceInfo.getName();
     }
+    inline virtual int getFd() const override { return mSock->mSid; }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));